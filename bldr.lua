@@ -18,4 +18,10 @@ if Project "axiom-render" then
     Compile "test/render_test.cpp"
     Import "axiom"
     Artifact { "out/render", type = "Console" }
-end
\ No newline at end of file
+end
+
+if Project "axiom-tests" then
+    Compile "test/unit/**"
+    Import "axiom"
+    Artifact { "out/tests", type = "Console" }
+end
@@ -10,4 +10,7 @@
 namespace axiom
 {
     using namespace nova::types;
+
+    // Affine transform without the constant projection row
+    using Mat4x3 = glm::mat4x3;
 }
\ No newline at end of file
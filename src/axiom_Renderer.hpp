@@ -32,7 +32,15 @@ namespace axiom
         virtual void CompileScene(CompiledScene& scene, nova::CommandPool cmd_pool, nova::Fence fence) = 0;
 
         virtual void ResetSamples() = 0;
+
+        // Refreshes instances whose transforms changed in the last CompiledScene::UpdateTransforms.
+        // Subject to the same synchronisation as Record
+        virtual void UpdateTransforms() = 0;
+
         virtual void SetCamera(Vec3 position, Quat rotation, f32 aspect, f32 fov) = 0;
+
+        // May update host mapped resources used by previously recorded commands, callers
+        // must wait for the last submission to complete before recording the next frame
         virtual void Record(nova::CommandList cmd, nova::Image target) = 0;
     };
 
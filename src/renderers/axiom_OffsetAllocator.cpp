@@ -0,0 +1,295 @@
+#include "axiom_OffsetAllocator.hpp"
+
+namespace axiom
+{
+    namespace
+    {
+        // Sizes are binned as floats with a 3 bit mantissa and 5 bit exponent, sizes
+        // below 8 are stored exactly as denormals
+
+        constexpr u32 MantissaBits  = 3;
+        constexpr u32 MantissaValue = 1 << MantissaBits;
+        constexpr u32 MantissaMask  = MantissaValue - 1;
+
+        constexpr u32 NoBin = UINT32_MAX;
+
+        // Smallest bin whose ranges are all at least size
+        u32 BinRoundUp(u32 size)
+        {
+            if (size < MantissaValue) {
+                return size;
+            }
+
+            u32 mantissa_start = u32(std::bit_width(size)) - 1 - MantissaBits;
+            u32 exponent = mantissa_start + 1;
+            u32 mantissa = (size >> mantissa_start) & MantissaMask;
+            if (size & ((1u << mantissa_start) - 1)) {
+                mantissa++;
+            }
+
+            // Mantissa overflow carries into the exponent
+            return (exponent << MantissaBits) + mantissa;
+        }
+
+        // Bin that a free range of size is stored in
+        u32 BinRoundDown(u32 size)
+        {
+            if (size < MantissaValue) {
+                return size;
+            }
+
+            u32 mantissa_start = u32(std::bit_width(size)) - 1 - MantissaBits;
+            u32 exponent = mantissa_start + 1;
+            u32 mantissa = (size >> mantissa_start) & MantissaMask;
+
+            return (exponent << MantissaBits) | mantissa;
+        }
+
+        u32 FindLowestSetBitAfter(u32 mask, u32 start)
+        {
+            if (start >= 32) {
+                return NoBin;
+            }
+
+            mask &= ~((1u << start) - 1);
+            return mask ? u32(std::countr_zero(mask)) : NoBin;
+        }
+    }
+
+    OffsetAllocator::OffsetAllocator(u32 _size)
+    {
+        Reset(_size);
+    }
+
+    void OffsetAllocator::Reset(u32 _size)
+    {
+        size = _size;
+
+        nodes.clear();
+        free_nodes.clear();
+
+        used_bins_top = 0;
+        used_bins.fill(0);
+        bin_heads.fill(OffsetAllocation::Invalid);
+
+        free_storage = 0;
+        allocations = 0;
+
+        if (size) {
+            InsertFree(CreateNode(0, size));
+        }
+    }
+
+    u32 OffsetAllocator::CreateNode(u32 offset, u32 node_size)
+    {
+        u32 index;
+        if (free_nodes.empty()) {
+            index = u32(nodes.size());
+            nodes.emplace_back();
+        } else {
+            index = free_nodes.back();
+            free_nodes.pop_back();
+            nodes[index] = {};
+        }
+
+        nodes[index].offset = offset;
+        nodes[index].size = node_size;
+
+        return index;
+    }
+
+    void OffsetAllocator::InsertFree(u32 index)
+    {
+        auto& node = nodes[index];
+        u32 bin = BinRoundDown(node.size);
+        u32 top = bin / BinsPerLeaf;
+        u32 leaf = bin % BinsPerLeaf;
+
+        used_bins_top |= 1u << top;
+        used_bins[top] |= u8(1u << leaf);
+
+        node.used = false;
+        node.bin_prev = OffsetAllocation::Invalid;
+        node.bin_next = bin_heads[bin];
+        if (node.bin_next != OffsetAllocation::Invalid) {
+            nodes[node.bin_next].bin_prev = index;
+        }
+        bin_heads[bin] = index;
+
+        free_storage += node.size;
+    }
+
+    void OffsetAllocator::RemoveFree(u32 index)
+    {
+        auto& node = nodes[index];
+
+        if (node.bin_prev != OffsetAllocation::Invalid) {
+            nodes[node.bin_prev].bin_next = node.bin_next;
+        } else {
+            u32 bin = BinRoundDown(node.size);
+            bin_heads[bin] = node.bin_next;
+
+            if (node.bin_next == OffsetAllocation::Invalid) {
+                u32 top = bin / BinsPerLeaf;
+                used_bins[top] &= u8(~(1u << (bin % BinsPerLeaf)));
+                if (!used_bins[top]) {
+                    used_bins_top &= ~(1u << top);
+                }
+            }
+        }
+
+        if (node.bin_next != OffsetAllocation::Invalid) {
+            nodes[node.bin_next].bin_prev = node.bin_prev;
+        }
+
+        node.bin_prev = OffsetAllocation::Invalid;
+        node.bin_next = OffsetAllocation::Invalid;
+
+        free_storage -= node.size;
+    }
+
+    OffsetAllocation OffsetAllocator::Allocate(u32 alloc_size, u32 alignment)
+    {
+        alloc_size = std::max(alloc_size, 1u);
+        alignment = std::max(alignment, 1u);
+
+        // Any range this large can hold the allocation at an aligned offset
+
+        u32 search_size = alloc_size + (alignment - 1);
+        if (search_size < alloc_size) {
+            return {};
+        }
+
+        u32 min_bin = BinRoundUp(search_size);
+        if (min_bin >= LeafBinCount) {
+            return {};
+        }
+
+        u32 top = min_bin / BinsPerLeaf;
+        u32 bin = NoBin;
+
+        if (used_bins_top & (1u << top)) {
+            u32 leaf = FindLowestSetBitAfter(used_bins[top], min_bin % BinsPerLeaf);
+            if (leaf != NoBin) {
+                bin = top * BinsPerLeaf + leaf;
+            }
+        }
+
+        if (bin == NoBin) {
+            top = FindLowestSetBitAfter(used_bins_top, top + 1);
+            if (top == NoBin) {
+                return {};
+            }
+            bin = top * BinsPerLeaf + u32(std::countr_zero(used_bins[top]));
+        }
+
+        u32 index = bin_heads[bin];
+        RemoveFree(index);
+
+        // Split off leading padding and any trailing remainder as free ranges
+
+        u32 padding = u32(nova::AlignUpPower2(u64(nodes[index].offset), alignment)) - nodes[index].offset;
+        if (padding) {
+            u32 pad = CreateNode(nodes[index].offset, padding);
+            nodes[pad].neighbour_prev = nodes[index].neighbour_prev;
+            nodes[pad].neighbour_next = index;
+            if (nodes[pad].neighbour_prev != OffsetAllocation::Invalid) {
+                nodes[nodes[pad].neighbour_prev].neighbour_next = pad;
+            }
+            nodes[index].neighbour_prev = pad;
+            nodes[index].offset += padding;
+            nodes[index].size -= padding;
+            InsertFree(pad);
+        }
+
+        u32 remainder = nodes[index].size - alloc_size;
+        if (remainder) {
+            u32 rest = CreateNode(nodes[index].offset + alloc_size, remainder);
+            nodes[rest].neighbour_prev = index;
+            nodes[rest].neighbour_next = nodes[index].neighbour_next;
+            if (nodes[rest].neighbour_next != OffsetAllocation::Invalid) {
+                nodes[nodes[rest].neighbour_next].neighbour_prev = rest;
+            }
+            nodes[index].neighbour_next = rest;
+            nodes[index].size = alloc_size;
+            InsertFree(rest);
+        }
+
+        nodes[index].used = true;
+        allocations++;
+
+        return { nodes[index].offset, index };
+    }
+
+    void OffsetAllocator::Free(OffsetAllocation allocation)
+    {
+        if (!allocation.IsValid()) {
+            return;
+        }
+
+        if (allocation.node >= nodes.size() || !nodes[allocation.node].used
+                || nodes[allocation.node].offset != allocation.offset) {
+            NOVA_THROW("Freeing unallocated range at offset {}", allocation.offset);
+        }
+
+        u32 index = allocation.node;
+        nodes[index].used = false;
+        allocations--;
+
+        // Merge with free neighbours, absorbing their nodes
+
+        u32 prev = nodes[index].neighbour_prev;
+        if (prev != OffsetAllocation::Invalid && !nodes[prev].used) {
+            RemoveFree(prev);
+            nodes[index].offset = nodes[prev].offset;
+            nodes[index].size += nodes[prev].size;
+            nodes[index].neighbour_prev = nodes[prev].neighbour_prev;
+            if (nodes[index].neighbour_prev != OffsetAllocation::Invalid) {
+                nodes[nodes[index].neighbour_prev].neighbour_next = index;
+            }
+            free_nodes.push_back(prev);
+        }
+
+        u32 next = nodes[index].neighbour_next;
+        if (next != OffsetAllocation::Invalid && !nodes[next].used) {
+            RemoveFree(next);
+            nodes[index].size += nodes[next].size;
+            nodes[index].neighbour_next = nodes[next].neighbour_next;
+            if (nodes[index].neighbour_next != OffsetAllocation::Invalid) {
+                nodes[nodes[index].neighbour_next].neighbour_prev = index;
+            }
+            free_nodes.push_back(next);
+        }
+
+        InsertFree(index);
+    }
+
+    u32 OffsetAllocator::GetAllocationSize(OffsetAllocation allocation) const
+    {
+        return allocation.IsValid() ? nodes[allocation.node].size : 0;
+    }
+
+    OffsetAllocatorStats OffsetAllocator::GetStats() const
+    {
+        OffsetAllocatorStats stats;
+        stats.total_free = free_storage;
+        stats.allocations = allocations;
+
+        // Every node is either an allocation or a free range
+        stats.free_regions = u32(nodes.size() - free_nodes.size()) - allocations;
+
+        if (used_bins_top) {
+            u32 top = u32(std::bit_width(used_bins_top)) - 1;
+            u32 bin = top * BinsPerLeaf + u32(std::bit_width(u32(used_bins[top]))) - 1;
+            for (u32 index = bin_heads[bin]; index != OffsetAllocation::Invalid; index = nodes[index].bin_next) {
+                stats.largest_free = std::max(stats.largest_free, nodes[index].size);
+            }
+        }
+
+        if (stats.total_free) {
+            stats.fragmentation = 1.f - f32(stats.largest_free) / f32(stats.total_free);
+        }
+
+        return stats;
+    }
+}
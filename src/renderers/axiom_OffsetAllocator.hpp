@@ -0,0 +1,94 @@
+#pragma once
+
+#include <axiom_Core.hpp>
+
+namespace axiom
+{
+    struct OffsetAllocation
+    {
+        static constexpr u32 Invalid = UINT32_MAX;
+
+        u32 offset = Invalid;
+        u32   node = Invalid;
+
+        bool IsValid() const noexcept
+        {
+            return offset != Invalid;
+        }
+    };
+
+    struct OffsetAllocatorStats
+    {
+        u64        total_free = 0;
+        u32      largest_free = 0;
+        u32      free_regions = 0;
+        u32       allocations = 0;
+
+        // 0 when all free space is contiguous, approaching 1 as it is split into many small regions
+        f32 fragmentation = 0.f;
+    };
+
+    // Manages ranges within a fixed size address space, such as a large backing GPU
+    // buffer, without touching the memory itself. Free ranges are binned by size in
+    // a two level segregated fit (TLSF) structure, with a small float encoding giving
+    // 8 bins per power of two. Allocation finds a bin through bit scans and free merges
+    // with both neighbours, so both are O(1)
+    struct OffsetAllocator
+    {
+        static constexpr u32 TopBinCount  = 32;
+        static constexpr u32 BinsPerLeaf  = 8;
+        static constexpr u32 LeafBinCount = TopBinCount * BinsPerLeaf;
+
+    private:
+        struct Node
+        {
+            u32 offset = 0;
+            u32   size = 0;
+
+            // Free list of the containing bin, unused while allocated
+            u32 bin_prev = OffsetAllocation::Invalid;
+            u32 bin_next = OffsetAllocation::Invalid;
+
+            // Adjacent ranges in address order
+            u32 neighbour_prev = OffsetAllocation::Invalid;
+            u32 neighbour_next = OffsetAllocation::Invalid;
+
+            bool used = false;
+        };
+
+        u32 size = 0;
+
+        std::vector<Node> nodes;
+        std::vector<u32>  free_nodes;
+
+        u32                           used_bins_top = 0;
+        std::array<u8,   TopBinCount>     used_bins = {};
+        std::array<u32, LeafBinCount>     bin_heads = {};
+
+        u64 free_storage = 0;
+        u32  allocations = 0;
+
+        u32  CreateNode(u32 offset, u32 size);
+        void InsertFree(u32 node);
+        void RemoveFree(u32 node);
+
+    public:
+        OffsetAllocator() = default;
+        OffsetAllocator(u32 size);
+
+        // Releases all allocations, making the whole range available again
+        void Reset(u32 size);
+
+        // Returns an invalid allocation if no free range is large enough. Alignment
+        // must be a power of two, and may cause up to alignment - 1 bytes of extra
+        // space to be searched for
+        OffsetAllocation Allocate(u32 size, u32 alignment = 1);
+        void Free(OffsetAllocation allocation);
+
+        u32 GetAllocationSize(OffsetAllocation allocation) const;
+        u32 GetSize() const { return size; }
+
+        // Walks the free list of the largest bin, intended for diagnostics rather than per allocation
+        OffsetAllocatorStats GetStats() const;
+    };
+}
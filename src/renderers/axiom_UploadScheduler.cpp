@@ -0,0 +1,149 @@
+#include "axiom_UploadScheduler.hpp"
+
+namespace axiom
+{
+    StagingRing::StagingRing(u64 _size)
+        : size(_size)
+    {}
+
+    u64 StagingRing::Allocate(u64 alloc_size, u64 alignment)
+    {
+        if (!size || alloc_size > size) {
+            return InvalidOffset;
+        }
+
+        // Restart from the beginning when empty, so that large allocations are not
+        // blocked by the position that the ring happened to drain at
+
+        if (head == tail) {
+            u64 pos = head % size;
+            if (pos) {
+                head += size - pos;
+                tail = head;
+            }
+        }
+
+        u64 pos = head % size;
+        u64 aligned_pos = nova::AlignUpPower2(pos, alignment);
+        u64 offset = head + (aligned_pos - pos);
+        if (aligned_pos + alloc_size > size) {
+            offset = head + (size - pos);
+            aligned_pos = 0;
+        }
+
+        if (offset + alloc_size - tail > size) {
+            return InvalidOffset;
+        }
+
+        head = offset + alloc_size;
+
+        return aligned_pos;
+    }
+
+    void StagingRing::EndFrame(u64 frame)
+    {
+        u64 last_end = frames.empty() ? tail : frames.back().end;
+        if (head != last_end) {
+            frames.push_back({ frame, head });
+        }
+    }
+
+    void StagingRing::Reclaim(u64 completed_frame)
+    {
+        usz reclaimed = 0;
+        while (reclaimed < frames.size() && frames[reclaimed].frame <= completed_frame) {
+            tail = frames[reclaimed++].end;
+        }
+        frames.erase(frames.begin(), frames.begin() + reclaimed);
+    }
+
+// -----------------------------------------------------------------------------
+
+    UploadScheduler::UploadScheduler(u64 staging_size)
+        : ring(staging_size)
+    {}
+
+    u64 UploadScheduler::Enqueue(u32 target, u64 target_offset, const void* data, u64 size)
+    {
+        u64 ticket = next_ticket++;
+
+        pending.push_back(PendingUpload {
+            .data = static_cast<const b8*>(data),
+            .size = size,
+            .target = target,
+            .target_offset = target_offset,
+            .ticket = ticket,
+        });
+        pending_bytes += size;
+
+        return ticket;
+    }
+
+    void UploadScheduler::Schedule(u64 frame, u64 completed_frame, b8* staging, std::vector<UploadCopy>& copies)
+    {
+        ring.Reclaim(completed_frame);
+
+        usz completed_frames = 0;
+        while (completed_frames < frame_tickets.size() && frame_tickets[completed_frames].first <= completed_frame) {
+            completed_ticket = frame_tickets[completed_frames++].second;
+        }
+        frame_tickets.erase(frame_tickets.begin(), frame_tickets.begin() + completed_frames);
+
+        // Only copies appended by this call are merged, the caller may keep earlier frames' copies
+        usz first_copy = copies.size();
+
+        u64 budget = frame_budget;
+        u64 max_chunk = std::min(chunk_size, ring.GetSize());
+        u64 last_ticket = 0;
+
+        usz staged = 0;
+        while (staged < pending.size()) {
+            auto& upload = pending[staged];
+            if (upload.progress == upload.size) {
+                last_ticket = upload.ticket;
+                staged++;
+                continue;
+            }
+
+            u64 chunk = std::min({ upload.size - upload.progress, max_chunk, budget });
+            if (!chunk) {
+                break;
+            }
+
+            u64 offset = ring.Allocate(chunk, alignment);
+            if (offset == StagingRing::InvalidOffset) {
+                // Out of staging memory until earlier frames complete
+                break;
+            }
+
+            std::memcpy(staging + offset, upload.data + upload.progress, chunk);
+
+            // Chunks that are contiguous in both staging and target share a copy
+
+            auto* last = copies.size() > first_copy ? &copies.back() : nullptr;
+            if (last && last->target == upload.target
+                    && last->staging_offset + last->size == offset
+                    && last->target_offset + last->size == upload.target_offset + upload.progress) {
+                last->size += chunk;
+            } else {
+                copies.push_back(UploadCopy {
+                    .staging_offset = offset,
+                    .target = upload.target,
+                    .target_offset = upload.target_offset + upload.progress,
+                    .size = chunk,
+                });
+            }
+
+            upload.progress += chunk;
+            pending_bytes -= chunk;
+            budget -= chunk;
+        }
+
+        pending.erase(pending.begin(), pending.begin() + staged);
+
+        ring.EndFrame(frame);
+        if (last_ticket) {
+            frame_tickets.push_back({ frame, last_ticket });
+        }
+    }
+}
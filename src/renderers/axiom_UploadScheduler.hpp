@@ -0,0 +1,102 @@
+#pragma once
+
+#include <axiom_Core.hpp>
+
+namespace axiom
+{
+    // Ring allocator over a staging buffer. Allocations made between calls to EndFrame
+    // belong to that frame, and are reclaimed together once the frame is known to have
+    // completed on the GPU. Frames are identified by monotonically increasing values,
+    // such as timeline fence values
+    struct StagingRing
+    {
+        static constexpr u64 InvalidOffset = UINT64_MAX;
+
+    private:
+        struct FrameMark
+        {
+            u64 frame;
+            u64   end;
+        };
+
+        u64 size = 0;
+
+        // Monotonic positions, wrapped into the buffer by size
+        u64 head = 0;
+        u64 tail = 0;
+
+        std::vector<FrameMark> frames;
+
+    public:
+        StagingRing() = default;
+        StagingRing(u64 size);
+
+        // Allocations are never split across the end of the ring, the remaining space
+        // is skipped instead. Returns InvalidOffset if the ring is full
+        u64 Allocate(u64 size, u64 alignment);
+
+        void EndFrame(u64 frame);
+        void Reclaim(u64 completed_frame);
+
+        u64 GetSize() const { return size; }
+        u64 GetUsed() const { return head - tail; }
+    };
+
+    struct UploadCopy
+    {
+        u64 staging_offset;
+        u32         target;
+        u64  target_offset;
+        u64           size;
+    };
+
+    // Streams uploads through a StagingRing, spreading them across frames. Each frame
+    // stages at most frame_budget bytes, splitting uploads into chunks of at most
+    // chunk_size so that large uploads make progress without stalling the frame.
+    // Uploads are processed in the order they were enqueued
+    struct UploadScheduler
+    {
+        u64 frame_budget = 64ull * 1024 * 1024;
+        u64   chunk_size =  4ull * 1024 * 1024;
+        u64    alignment = 16;
+
+    private:
+        struct PendingUpload
+        {
+            const b8*        data;
+            u64              size;
+            u32            target;
+            u64     target_offset;
+            u64          progress = 0;
+            u64            ticket;
+        };
+
+        StagingRing ring;
+
+        std::vector<PendingUpload> pending;
+        u64                  pending_bytes = 0;
+
+        // Last ticket fully staged in each frame still in flight
+        std::vector<std::pair<u64, u64>> frame_tickets;
+
+        u64      next_ticket = 1;
+        u64 completed_ticket = 0;
+
+    public:
+        UploadScheduler(u64 staging_size);
+
+        // Source data must remain valid until the returned ticket completes
+        u64 Enqueue(u32 target, u64 target_offset, const void* data, u64 size);
+
+        // Reclaims staging memory from frames up to and including completed_frame, then
+        // writes this frame's share of pending uploads into the mapped staging memory and
+        // appends the copies the caller must record for the frame
+        void Schedule(u64 frame, u64 completed_frame, b8* staging, std::vector<UploadCopy>& copies);
+
+        // True once the upload has been copied by a completed frame
+        bool IsComplete(u64 ticket) const { return ticket <= completed_ticket; }
+
+        u64 GetPendingBytes() const { return pending_bytes; }
+        const StagingRing& GetRing() const { return ring; }
+    };
+}
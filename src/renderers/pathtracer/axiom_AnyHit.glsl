@@ -11,9 +11,10 @@ void main()
     vec3 w = vec3(1.0 - bary.x - bary.y, bary.x, bary.y);
 
     // Indices
-    uint i0 = geometry.indices[gl_PrimitiveID * 3 + 0].value;
-    uint i1 = geometry.indices[gl_PrimitiveID * 3 + 1].value;
-    uint i2 = geometry.indices[gl_PrimitiveID * 3 + 2].value;
+    uvec3 indices = axiom_LoadTriangleIndices(geometry, gl_PrimitiveID);
+    uint i0 = indices.x;
+    uint i1 = indices.y;
+    uint i2 = indices.z;
 
     // Shading attributes
     ShadingAttributes sa0 = geometry.shadingAttributes[i0];
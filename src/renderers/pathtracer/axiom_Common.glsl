@@ -3,6 +3,7 @@
 #extension GL_EXT_nonuniform_qualifier                   : require
 #extension GL_EXT_shader_image_load_formatted            : require
 #extension GL_EXT_shader_explicit_arithmetic_types_int8  : require
+#extension GL_EXT_shader_explicit_arithmetic_types_int16 : require
 #extension GL_EXT_shader_explicit_arithmetic_types_int64 : require
 
 layout(set = 0, binding = 0) uniform texture2D Image2D[];
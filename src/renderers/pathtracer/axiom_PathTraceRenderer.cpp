@@ -11,6 +11,7 @@ namespace axiom
     {
         i32                vertex_offset;
         u32                  first_index;
+        u32              first_index_u16;
         u32              geometry_offset;
         nova::AccelerationStructure blas;
     };
@@ -40,6 +41,8 @@ namespace axiom
         u64 shading_attributes;
         u64            indices;
         u64           material;
+        u32         index_size;
+        u32           reserved;
     };
 
     struct PathTraceRenderer : Renderer
@@ -56,14 +59,15 @@ namespace axiom
         u32                  sample_count;
 
         nova::Buffer                        material_buffer;
-        nova::HashMap<void*, u64>        material_addresses;
-        nova::HashMap<void*, nova::Image> loaded_textures;
+        std::vector<u64>           material_addresses;
+        std::vector<nova::Image>      loaded_textures;
 
         nova::Buffer       shading_attributes_buffer;
         nova::Buffer                    index_buffer;
+        nova::Buffer                index_u16_buffer;
         nova::Buffer            geometry_info_buffer;
         nova::Buffer            instance_data_buffer;
-        nova::HashMap<void*, CompiledMesh> mesh_data;
+        std::vector<CompiledMesh>          mesh_data;
 
         nova::Buffer noise_buffer;
 
@@ -95,6 +99,9 @@ namespace axiom
         virtual void SetCamera(Vec3 position, Quat rotation, f32 aspect, f32 fov);
         virtual void Record(nova::CommandList cmd, nova::Image target);
         virtual void ResetSamples();
+
+        // TLAS instance transforms are only written by CompileScene
+        virtual void UpdateTransforms() {}
     };
 
     nova::Ref<Renderer> CreatePathTraceRenderer(nova::Context context)
@@ -124,19 +131,20 @@ namespace axiom
     {
         shading_attributes_buffer.Destroy();
         index_buffer.Destroy();
+        index_u16_buffer.Destroy();
         tlas_instance_buffer.Destroy();
         geometry_info_buffer.Destroy();
         instance_data_buffer.Destroy();
         noise_buffer.Destroy();
         hit_groups.Destroy();
 
-        for (auto&[p, data] : mesh_data) {
+        for (auto& data : mesh_data) {
             data.blas.Destroy();
         }
         tlas.Destroy();
 
         material_buffer.Destroy();
-        for (auto&[p, texture] : loaded_textures) {
+        for (auto& texture : loaded_textures) {
             texture.Destroy();
         }
 
@@ -155,28 +163,27 @@ namespace axiom
     {
         (void)cmd_pool, (void)fence;
 
-        for (auto& texture : scene->textures) {
-            loaded_textures.insert({ texture.Raw(), {} });
-        }
+        loaded_textures.resize(scene->textures.size());
 
         std::atomic_uint64_t total_resident_textures = 0;
 
 #pragma omp parallel for
         for (u32 i = 0; i < scene->textures.size(); ++i) {
             auto& texture = scene->textures[i];
-            auto& loaded_texture = loaded_textures.at(texture.Raw());
+            auto& loaded_texture = loaded_textures[i];
+            auto data = texture.GetData();
 
-            if (texture->data.size()) {
+            if (data.size()) {
                 loaded_texture = nova::Image::Create(context,
-                    Vec3U(texture->size, 0),
+                    Vec3U(texture.size, 0),
                     nova::ImageUsage::Sampled,
-                    texture->format,
+                    texture.format,
                     {});
 
                 loaded_texture.Set({}, loaded_texture.GetExtent(),
-                    texture->data.data());
+                    data.data());
 
-                total_resident_textures += texture->data.size();
+                total_resident_textures += data.size();
             }
         }
 
@@ -187,24 +194,24 @@ namespace axiom
             nova::BufferUsage::Storage,
             nova::BufferFlags::DeviceLocal | nova::BufferFlags::Mapped);
 
+        material_addresses.resize(scene->materials.size());
         for (u32 i = 0; i < scene->materials.size(); ++i) {
             auto& material = scene->materials[i];
 
-            u64 address = material_buffer.GetAddress() + (i * sizeof(GPU_Material));
-            material_addresses[material.Raw()] = address;
+            material_addresses[i] = material_buffer.GetAddress() + (i * sizeof(GPU_Material));
 
             material_buffer.Set<GPU_Material>({{
-                .basecolor_alpha     = loaded_textures.at(material->basecolor_alpha.Raw()    ).GetDescriptor(),
-                .normals             = loaded_textures.at(material->normals.Raw()            ).GetDescriptor(),
-                .emissivity          = loaded_textures.at(material->emissivity.Raw()         ).GetDescriptor(),
-                .transmission        = loaded_textures.at(material->transmission.Raw()       ).GetDescriptor(),
-                .metalness_roughness = loaded_textures.at(material->metalness_roughness.Raw()).GetDescriptor(),
-
-                .alpha_cutoff = material->alpha_cutoff,
-                .alpha_mask   = material->alpha_mask,
-                .alpha_blend  = material->alpha_blend,
-                .thin        = material->thin,
-                .subsurface  = material->subsurface,
+                .basecolor_alpha     = loaded_textures[material.basecolor_alpha.value    ].GetDescriptor(),
+                .normals             = loaded_textures[material.normals.value            ].GetDescriptor(),
+                .emissivity          = loaded_textures[material.emissivity.value         ].GetDescriptor(),
+                .transmission        = loaded_textures[material.transmission.value       ].GetDescriptor(),
+                .metalness_roughness = loaded_textures[material.metalness_roughness.value].GetDescriptor(),
+
+                .alpha_cutoff = material.alpha_cutoff,
+                .alpha_mask   = material.alpha_mask,
+                .alpha_blend  = material.alpha_blend,
+                .thin        = material.thin,
+                .subsurface  = material.subsurface,
             }}, i);
         }
     }
@@ -246,14 +253,16 @@ namespace axiom
         u64 vertex_count = 0;
         u64 max_per_blas_vertex_count = 0;
         u64 index_count = 0;
+        u64 index_u16_count = 0;
         for (auto& mesh : scene->meshes) {
-            max_per_blas_vertex_count = std::max(max_per_blas_vertex_count, mesh->position_attributes.size());
-            vertex_count += mesh->position_attributes.size();
-            index_count += mesh->indices.size();
+            max_per_blas_vertex_count = std::max(max_per_blas_vertex_count, mesh.GetVertexCount());
+            vertex_count += mesh.GetVertexCount();
+            index_count += mesh.GetData().indices.size();
+            index_u16_count += mesh.GetData().indices_u16.size();
         }
 
 #ifdef AXIOM_TRACE_COMPILE // --------------------------------------------------
-        NOVA_LOG("Compiling, unique vertices = {}, unique indices = {}", vertex_count, index_count);
+        NOVA_LOG("Compiling, unique vertices = {}, unique indices = {} ({} 16-bit)", vertex_count, index_count + index_u16_count, index_u16_count);
 #endif // ----------------------------------------------------------------------
 
         shading_attributes_buffer = nova::Buffer::Create(context,
@@ -261,28 +270,56 @@ namespace axiom
             nova::BufferUsage::Storage | nova::BufferUsage::AccelBuild,
             nova::BufferFlags::DeviceLocal | nova::BufferFlags::Mapped);
 
-        index_buffer = nova::Buffer::Create(context,
-            index_count * sizeof(u32),
-            nova::BufferUsage::Index | nova::BufferUsage::AccelBuild,
-            nova::BufferFlags::DeviceLocal | nova::BufferFlags::Mapped);
+        // Index streams are left unallocated when no sub mesh uses them
+
+        if (index_count) {
+            index_buffer = nova::Buffer::Create(context,
+                index_count * sizeof(u32),
+                nova::BufferUsage::Index | nova::BufferUsage::AccelBuild,
+                nova::BufferFlags::DeviceLocal | nova::BufferFlags::Mapped);
+        }
+
+        if (index_u16_count) {
+            index_u16_buffer = nova::Buffer::Create(context,
+                index_u16_count * sizeof(u16),
+                nova::BufferUsage::Index | nova::BufferUsage::AccelBuild,
+                nova::BufferFlags::DeviceLocal | nova::BufferFlags::Mapped);
+        }
 
         u32 geometry_count = 0;
 
         u64 vertex_offset = 0;
         u64 index_offset = 0;
+        u64 index_u16_offset = 0;
         NOVA_LOGEXPR(scene->meshes.size());
-        for (auto& mesh : scene->meshes) {
-            mesh_data[mesh.Raw()] = CompiledMesh{ i32(vertex_offset), u32(index_offset), geometry_count };
-
-            shading_attributes_buffer.Set<ShadingAttributes>(mesh->shading_attributes, vertex_offset);
-            vertex_offset += mesh->position_attributes.size();
+        mesh_data.resize(scene->meshes.size());
+        for (u32 i = 0; i < scene->meshes.size(); ++i) {
+            auto& mesh = scene->meshes[i];
+            auto geometry = mesh.GetData();
+            mesh_data[i] = CompiledMesh{ i32(vertex_offset), u32(index_offset), u32(index_u16_offset), geometry_count };
+
+            shading_attributes_buffer.Set<ShadingAttributes>({ geometry.shading_attributes.data(), geometry.shading_attributes.size() }, vertex_offset);
+            vertex_offset += mesh.GetVertexCount();
+
+            if (!geometry.indices.empty()) {
+                index_buffer.Set<u32>({ geometry.indices.data(), geometry.indices.size() }, index_offset);
+                index_offset += geometry.indices.size();
+            }
 
-            index_buffer.Set<u32>(mesh->indices, index_offset);
-            index_offset += mesh->indices.size();
+            if (!geometry.indices_u16.empty()) {
+                index_u16_buffer.Set<u16>({ geometry.indices_u16.data(), geometry.indices_u16.size() }, index_u16_offset);
+                index_u16_offset += geometry.indices_u16.size();
+            }
 
-            geometry_count += u32(mesh->sub_meshes.size());
+            geometry_count += u32(mesh.sub_meshes.size());
         }
 
+        auto GetIndexAddress = [&](const CompiledMesh& data, const TriSubMesh& sub_mesh) {
+            return sub_mesh.index_type == nova::IndexType::U16
+                ? index_u16_buffer.GetAddress() + (data.first_index_u16 + sub_mesh.first_index) * sizeof(u16)
+                :     index_buffer.GetAddress() + (data.first_index     + sub_mesh.first_index) * sizeof(u32);
+        };
+
         geometry_info_buffer = nova::Buffer::Create(context,
             geometry_count * sizeof(GPU_GeometryInfo),
             nova::BufferUsage::Storage,
@@ -316,20 +353,20 @@ namespace axiom
             u64 build_blas_size = 0;
             for (u32 i = 0; i < scene->meshes.size(); ++i) {
                 auto& mesh = scene->meshes[i];
-                auto& data = mesh_data.at(mesh.Raw());
+                auto& data = mesh_data[i];
 
                 builder.Prepare(
                     nova::AccelerationStructureType::BottomLevel,
                     nova::AccelerationStructureFlags::AllowDataAccess
                     | nova::AccelerationStructureFlags::AllowCompaction
-                    | nova::AccelerationStructureFlags::PreferFastTrace, u32(mesh->sub_meshes.size()));
+                    | nova::AccelerationStructureFlags::PreferFastTrace, u32(mesh.sub_meshes.size()));
 
-                for (u32 j = 0; j < mesh->sub_meshes.size(); ++j) {
-                    auto& sub_mesh = mesh->sub_meshes[j];
+                for (u32 j = 0; j < mesh.sub_meshes.size(); ++j) {
+                    auto& sub_mesh = mesh.sub_meshes[j];
 
                     builder.SetTriangles(j,
-                        pos_attrib_buffer.GetAddress() +  sub_mesh.vertex_offset                  * sizeof(Vec3), nova::Format::RGBA32_SFloat, u32(sizeof(Vec3)), sub_mesh.max_vertex,
-                            index_buffer.GetAddress() + (sub_mesh.first_index + data.first_index) * sizeof(u32),  nova::IndexType::U32,                           sub_mesh.index_count / 3);
+                        pos_attrib_buffer.GetAddress() + sub_mesh.vertex_offset * sizeof(Vec3), nova::Format::RGBA32_SFloat, u32(sizeof(Vec3)), sub_mesh.max_vertex,
+                        GetIndexAddress(data, sub_mesh),                                        sub_mesh.index_type,                           sub_mesh.index_count / 3);
                 }
 
                 scratch_size = std::max(scratch_size, builder.GetBuildScratchSize());
@@ -343,42 +380,55 @@ namespace axiom
                 nova::AccelerationStructureType::BottomLevel);
             NOVA_DEFER(&) { build_blas.Destroy(); };
 
+            std::vector<Vec3> decoded_positions;
+
             for (u32 i = 0; i < scene->meshes.size(); ++i) {
                 auto& mesh = scene->meshes[i];
-                auto& data = mesh_data.at(mesh.Raw());
+                auto& data = mesh_data[i];
 
                 // Load position data
 
-                pos_attrib_buffer.Set<Vec3>(mesh->position_attributes);
+                // Quantised meshes are decoded to object space here, keeping BLAS
+                // vertex formats and position fetch identical for both storage formats
+
+                if (mesh.IsQuantised()) {
+                    mesh.DecodePositions(decoded_positions);
+                    pos_attrib_buffer.Set<Vec3>(decoded_positions);
+                } else {
+                    auto positions = mesh.GetData().position_attributes;
+                    pos_attrib_buffer.Set<Vec3>({ positions.data(), positions.size() });
+                }
                 builder.Prepare(
                     nova::AccelerationStructureType::BottomLevel,
                     nova::AccelerationStructureFlags::AllowDataAccess
                     | nova::AccelerationStructureFlags::AllowCompaction
-                    | nova::AccelerationStructureFlags::PreferFastTrace, u32(mesh->sub_meshes.size()));
+                    | nova::AccelerationStructureFlags::PreferFastTrace, u32(mesh.sub_meshes.size()));
 
-                for (u32 j = 0; j < mesh->sub_meshes.size(); ++j) {
-                    auto& sub_mesh = mesh->sub_meshes[j];
+                for (u32 j = 0; j < mesh.sub_meshes.size(); ++j) {
+                    auto& sub_mesh = mesh.sub_meshes[j];
                     auto geometry_index = data.geometry_offset + j;
 
                     // Add geometry to build
 
                     builder.SetTriangles(j,
-                        pos_attrib_buffer.GetAddress() +  sub_mesh.vertex_offset                   * sizeof(Vec3), nova::Format::RGBA32_SFloat, u32(sizeof(Vec3)), sub_mesh.max_vertex,
-                             index_buffer.GetAddress() + (sub_mesh.first_index + data.first_index) * sizeof(u32),  nova::IndexType::U32,                           sub_mesh.index_count / 3);
+                        pos_attrib_buffer.GetAddress() + sub_mesh.vertex_offset * sizeof(Vec3), nova::Format::RGBA32_SFloat, u32(sizeof(Vec3)), sub_mesh.max_vertex,
+                        GetIndexAddress(data, sub_mesh),                                        sub_mesh.index_type,                           sub_mesh.index_count / 3);
 
                     // Store geometry offsets and material
 
                     geometry_info_buffer.Set<GPU_GeometryInfo>({{
                         .shading_attributes = shading_attributes_buffer.GetAddress() + (data.vertex_offset + sub_mesh.vertex_offset) * sizeof(ShadingAttributes),
-                        .indices =                index_buffer.GetAddress() + (data.first_index   + sub_mesh.first_index  ) * sizeof(u32),
-                        .material = material_addresses.at(sub_mesh.material.Raw()),
+                        .indices = GetIndexAddress(data, sub_mesh),
+                        .material = material_addresses[sub_mesh.material.value],
+                        .index_size = sub_mesh.index_type == nova::IndexType::U16 ? u32(sizeof(u16)) : u32(sizeof(u32)),
                     }}, geometry_index);
 
                     // Bind shaders
 
                     u32 sbt_index = SBT_Opaque;
-                    if (sub_mesh.material->alpha_mask
-                            || sub_mesh.material->alpha_blend) {
+                    auto& material = scene->Get(sub_mesh.material);
+                    if (material.alpha_mask
+                            || material.alpha_blend) {
                         sbt_index = SBT_AlphaMasked;
                     }
                     pipeline.WriteHandle(hit_groups.GetMapped(), geometry_index, sbt_index);
@@ -420,7 +470,7 @@ namespace axiom
         u32 selected_instance_count = 0;
         for (u32 i = 0; i < scene->instances.size(); ++i) {
             auto& instance = scene->instances[i];
-            auto& data = mesh_data.at(instance->mesh.Raw());
+            auto& data = mesh_data[instance.mesh.value];
             if (!data.blas)
                 continue;
 
@@ -432,7 +482,7 @@ namespace axiom
                 tlas_instance_buffer.GetMapped(),
                 selected_instance_count,
                 data.blas,
-                instance->transform,
+                Mat4(instance.transform),
                 data.geometry_offset,
                 0xFF,
                 data.geometry_offset,
@@ -440,15 +490,18 @@ namespace axiom
             selected_instance_count++;
 
 #ifdef AXIOM_TRACE_COMPILE // --------------------------------------------------
-            instanced_vertex_count += instance->mesh->position_attributes.size();
-            instanced_index_count += instance->mesh->indices.size();
+            auto& mesh = scene->Get(instance.mesh);
+            instanced_vertex_count += mesh.GetVertexCount();
+            for (auto& sub_mesh : mesh.sub_meshes) {
+                instanced_index_count += sub_mesh.index_count;
+            }
 #endif // ----------------------------------------------------------------------
         }
 
 #ifdef AXIOM_TRACE_COMPILE // --------------------------------------------------
         NOVA_LOG("Compiling scene:");
         NOVA_LOG("  vertices   = {}", vertex_count);
-        NOVA_LOG("  indices    = {}", index_count);
+        NOVA_LOG("  indices    = {} ({} 16-bit)", index_count + index_u16_count, index_u16_count);
         NOVA_LOG("  meshes     = {}", scene->meshes.size());
         NOVA_LOG("  geometries = {}", geometry_count);
         NOVA_LOG("  instances  = {}", scene->instances.size());
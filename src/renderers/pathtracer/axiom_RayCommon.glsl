@@ -23,6 +23,10 @@ layout(buffer_reference, scalar, buffer_reference_align = 4) readonly buffer Ind
     uint value;
 };
 
+layout(buffer_reference, scalar, buffer_reference_align = 2) readonly buffer Index16 {
+    uint16_t value;
+};
+
 layout(buffer_reference, scalar, buffer_reference_align = 4) readonly buffer Material {
     uint     baseColor_alpha;
     uint             normals;
@@ -45,8 +49,26 @@ layout(buffer_reference, scalar, buffer_reference_align = 8) readonly buffer Geo
     ShadingAttributes shadingAttributes;
     Index                       indices;
     Material                   material;
+    uint                      indexSize;
+    uint                       reserved;
 };
 
+uvec3 axiom_LoadTriangleIndices(GeometryInfo geometry, uint primID)
+{
+    if (geometry.indexSize == 2) {
+        Index16 indices = Index16(uint64_t(geometry.indices));
+        return uvec3(
+            indices[primID * 3 + 0].value,
+            indices[primID * 3 + 1].value,
+            indices[primID * 3 + 2].value);
+    }
+
+    return uvec3(
+        geometry.indices[primID * 3 + 0].value,
+        geometry.indices[primID * 3 + 1].value,
+        geometry.indices[primID * 3 + 2].value);
+}
+
 layout(push_constant, scalar) uniform pc_ {
     uint64_t           tlas;
     GeometryInfo geometries;
@@ -181,9 +181,10 @@ void main()
 
             // Indices
             uint primID = hitObjectGetPrimitiveIndexNV(hit);
-            uint i0 = geometry.indices[primID * 3 + 0].value;
-            uint i1 = geometry.indices[primID * 3 + 1].value;
-            uint i2 = geometry.indices[primID * 3 + 2].value;
+            uvec3 indices = axiom_LoadTriangleIndices(geometry, primID);
+            uint i0 = indices.x;
+            uint i1 = indices.y;
+            uint i2 = indices.z;
 
             // Shading attributes
             ShadingAttributes sa0 = geometry.shadingAttributes[i0];
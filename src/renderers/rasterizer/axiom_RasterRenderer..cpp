@@ -41,6 +41,13 @@ namespace axiom
 
 // -----------------------------------------------------------------------------
 
+    struct RasterMeshOffsets
+    {
+        i32   vertex_offset;
+        u32     first_index;
+        u32 first_index_u16;
+    };
+
     struct RasterRenderer : Renderer
     {
         CompiledScene* scene = nullptr;
@@ -50,13 +57,19 @@ namespace axiom
         nova::Buffer position_attribute_buffer;
         nova::Buffer  shading_attribute_buffer;
         nova::Buffer              index_buffer;
+        nova::Buffer          index_u16_buffer;
 
-        nova::HashMap<void*, std::pair<i32, u32>> mesh_offsets;
+        std::vector<RasterMeshOffsets> mesh_offsets;
 
         nova::Buffer transform_buffer;
 
-        nova::Buffer indirect_buffer;
-        u32           indirect_count;
+        nova::Buffer     indirect_buffer;
+        u32               indirect_count;
+        nova::Buffer indirect_u16_buffer;
+        u32           indirect_u16_count;
+        bool                    has_lods = false;
+        std::vector<u32>       instance_lods;
+        bool         quantised_positions = false;
 
         nova::Shader   vertex_shader;
         nova::Shader fragment_shader;
@@ -64,16 +77,25 @@ namespace axiom
         nova::Image depth_image;
 
         Mat4 view_proj;
+        Vec3  view_pos;
+        f32   view_fov;
 
         RasterRenderer();
         ~RasterRenderer();
 
         virtual void CompileScene(CompiledScene& scene, nova::CommandPool cmd_pool, nova::Fence fence);
 
+        void WriteTransforms(bool updated_only);
+        void WriteDraws(const LodView* view);
+
         virtual void SetCamera(Vec3 position, Quat rotation, f32 aspect, f32 fov);
+
+        // Rewrites indirect draws in host mapped memory when selected LODs change. The
+        // previous submission reading them must have completed before this is called
         virtual void Record(nova::CommandList cmd, nova::Image target);
 
         virtual void ResetSamples() {}
+        virtual void UpdateTransforms();
     };
 
     nova::Ref<Renderer> CreateRasterRenderer(nova::Context context)
@@ -93,8 +115,10 @@ namespace axiom
         position_attribute_buffer.Destroy();
         shading_attribute_buffer.Destroy();
         index_buffer.Destroy();
+        index_u16_buffer.Destroy();
         transform_buffer.Destroy();
         indirect_buffer.Destroy();
+        indirect_u16_buffer.Destroy();
 
         vertex_shader.Destroy();
         fragment_shader.Destroy();
@@ -111,17 +135,25 @@ namespace axiom
 
         u64 vertex_count = 0;
         u64 index_count = 0;
+        u64 index_u16_count = 0;
         for (auto& mesh : scene->meshes) {
-            vertex_count += mesh->position_attributes.size();
-            index_count += mesh->indices.size();
+            vertex_count += mesh.GetVertexCount();
+            index_count += mesh.GetData().indices.size();
+            index_u16_count += mesh.GetData().indices_u16.size();
         }
 
+        // Quantised positions are only consumed directly when every mesh uses them,
+        // mixed scenes fall back to decoding into float positions
+
+        quantised_positions = !scene->meshes.empty()
+            && std::ranges::all_of(scene->meshes, [](auto& mesh) { return mesh.IsQuantised(); });
+
 #ifdef AXIOM_TRACE_COMPILE // --------------------------------------------------
-        NOVA_LOG("Compiling, unique vertices = {}, unique indices = {}", vertex_count, index_count);
+        NOVA_LOG("Compiling, unique vertices = {}, unique indices = {} ({} 16-bit)", vertex_count, index_count + index_u16_count, index_u16_count);
 #endif // ----------------------------------------------------------------------
 
         position_attribute_buffer = nova::Buffer::Create(context,
-            vertex_count * sizeof(Vec3),
+            vertex_count * (quantised_positions ? sizeof(GPU_QuantisedPosition) : sizeof(Vec3)),
             nova::BufferUsage::Storage,
             nova::BufferFlags::DeviceLocal | nova::BufferFlags::Mapped);
 
@@ -130,48 +162,88 @@ namespace axiom
             nova::BufferUsage::Storage,
             nova::BufferFlags::DeviceLocal | nova::BufferFlags::Mapped);
 
-        index_buffer = nova::Buffer::Create(context,
-            index_count * sizeof(u32),
-            nova::BufferUsage::Index,
-            nova::BufferFlags::DeviceLocal | nova::BufferFlags::Mapped);
+        // Index and indirect streams are left unallocated when no sub mesh uses them,
+        // Record skips their draws
+
+        if (index_count) {
+            index_buffer = nova::Buffer::Create(context,
+                index_count * sizeof(u32),
+                nova::BufferUsage::Index,
+                nova::BufferFlags::DeviceLocal | nova::BufferFlags::Mapped);
+        }
+
+        if (index_u16_count) {
+            index_u16_buffer = nova::Buffer::Create(context,
+                index_u16_count * sizeof(u16),
+                nova::BufferUsage::Index,
+                nova::BufferFlags::DeviceLocal | nova::BufferFlags::Mapped);
+        }
+
+        std::vector<Vec3> decoded_positions;
 
         u64 vertex_offset = 0;
         u64 index_offset = 0;
-        for (auto& mesh : scene->meshes) {
-            mesh_offsets[mesh.Raw()] = { i32(vertex_offset), u32(index_offset) };
+        u64 index_u16_offset = 0;
+        mesh_offsets.resize(scene->meshes.size());
+        for (u32 i = 0; i < scene->meshes.size(); ++i) {
+            auto& mesh = scene->meshes[i];
+            auto geometry = mesh.GetData();
+            mesh_offsets[i] = { i32(vertex_offset), u32(index_offset), u32(index_u16_offset) };
+
+            if (quantised_positions) {
+                position_attribute_buffer.Set<GPU_QuantisedPosition>({ geometry.quantised_positions.data(), geometry.quantised_positions.size() }, vertex_offset);
+            } else if (mesh.IsQuantised()) {
+                mesh.DecodePositions(decoded_positions);
+                position_attribute_buffer.Set<Vec3>(decoded_positions, vertex_offset);
+            } else {
+                position_attribute_buffer.Set<Vec3>({ geometry.position_attributes.data(), geometry.position_attributes.size() }, vertex_offset);
+            }
+            shading_attribute_buffer.Set<ShadingAttributes>({ geometry.shading_attributes.data(), geometry.shading_attributes.size() }, vertex_offset);
+            vertex_offset += mesh.GetVertexCount();
+
+            if (!geometry.indices.empty()) {
+                index_buffer.Set<u32>({ geometry.indices.data(), geometry.indices.size() }, index_offset);
+                index_offset += geometry.indices.size();
+            }
+
+            if (!geometry.indices_u16.empty()) {
+                index_u16_buffer.Set<u16>({ geometry.indices_u16.data(), geometry.indices_u16.size() }, index_u16_offset);
+                index_u16_offset += geometry.indices_u16.size();
+            }
+        }
 
-            position_attribute_buffer.Set<Vec3>(mesh->position_attributes, vertex_offset);
-            shading_attribute_buffer.Set<ShadingAttributes>(mesh->shading_attributes, vertex_offset);
-            vertex_offset += mesh->position_attributes.size();
+        u64 draw_count = 0;
+        u64 draw_u16_count = 0;
+        for (auto& instance : scene->instances) {
+            for (auto& sub_mesh : scene->Get(instance.mesh).sub_meshes) {
+                (sub_mesh.index_type == nova::IndexType::U16 ? draw_u16_count : draw_count)++;
+                has_lods |= !sub_mesh.lods.empty();
+            }
+        }
 
-            index_buffer.Set<u32>(mesh->indices, index_offset);
-            index_offset += mesh->indices.size();
+        if (draw_count) {
+            indirect_buffer = nova::Buffer::Create(context, draw_count * sizeof VkDrawIndexedIndirectCommand,
+                nova::BufferUsage::Indirect,
+                nova::BufferFlags::DeviceLocal | nova::BufferFlags::Mapped);
         }
 
-        transform_buffer = nova::Buffer::Create(context, scene->instances.size() * sizeof Mat4,
+        if (draw_u16_count) {
+            indirect_u16_buffer = nova::Buffer::Create(context, draw_u16_count * sizeof VkDrawIndexedIndirectCommand,
+                nova::BufferUsage::Indirect,
+                nova::BufferFlags::DeviceLocal | nova::BufferFlags::Mapped);
+        }
+
+        // Transforms are stored per draw, so that per sub mesh dequantisation can
+        // be folded into the instance transform
+
+        transform_buffer = nova::Buffer::Create(context, (draw_count + draw_u16_count) * sizeof Mat4x3,
             nova::BufferUsage::Storage,
             nova::BufferFlags::DeviceLocal | nova::BufferFlags::Mapped);
 
-        indirect_buffer = nova::Buffer::Create(context, scene->instances.size() * sizeof VkDrawIndexedIndirectCommand,
-            nova::BufferUsage::Indirect,
-            nova::BufferFlags::DeviceLocal | nova::BufferFlags::Mapped);
+        WriteTransforms(false);
 
-        transform_buffer.Set<Mat4>({Mat4(1.f)});
-
-        indirect_count = u32(scene->instances.size());
-        for (u32 i = 0; i < scene->instances.size(); ++i) {
-            auto& instance = scene->instances[i];
-            auto& offsets = mesh_offsets.at(instance->mesh.Raw());
-            indirect_buffer.Set<VkDrawIndexedIndirectCommand>({{
-                .indexCount = u32(instance->mesh->indices.size()),
-                .instanceCount = 1,
-                .firstIndex = offsets.second,
-                .vertexOffset = offsets.first,
-                .firstInstance = i,
-            }}, i);
-
-            transform_buffer.Set<Mat4>({instance->transform}, i);
-        }
+        instance_lods.assign(scene->instances.size(), UINT32_MAX);
+        WriteDraws(nullptr);
 
         vertex_shader = nova::Shader::Create(context, nova::ShaderLang::Glsl,
             nova::ShaderStage::Vertex, "main", "src/renderers/rasterizer/axiom_Vertex.glsl", {});
@@ -180,8 +252,93 @@ namespace axiom
             nova::ShaderStage::Fragment, "main", "src/renderers/rasterizer/axiom_Fragment.glsl", {});
     }
 
+    void RasterRenderer::WriteTransforms(bool updated_only)
+    {
+        u32 draw_index = 0;
+        for (auto& instance : scene->instances) {
+            auto& mesh = scene->Get(instance.mesh);
+
+            if (updated_only && (instance.node == TransformHierarchy::InvalidNode
+                    || !scene->transforms.IsUpdated(instance.node))) {
+                draw_index += u32(mesh.sub_meshes.size());
+                continue;
+            }
+
+            for (auto& sub_mesh : mesh.sub_meshes) {
+                Mat4 transform = Mat4(instance.transform);
+                if (quantised_positions) {
+                    transform *= GetDequantisationTransform(mesh, sub_mesh);
+                }
+                transform_buffer.Set<Mat4x3>({Mat4x3(transform)}, draw_index++);
+            }
+        }
+    }
+
+    void RasterRenderer::UpdateTransforms()
+    {
+        WriteTransforms(true);
+    }
+
+    void RasterRenderer::WriteDraws(const LodView* view)
+    {
+        // Draw slots are fixed per sub mesh, only instances whose selected level
+        // changed since the last write are rewritten
+
+        indirect_count = 0;
+        indirect_u16_count = 0;
+        u32 draw_index = 0;
+        for (u32 i = 0; i < scene->instances.size(); ++i) {
+            auto& instance = scene->instances[i];
+            auto& mesh = scene->Get(instance.mesh);
+            auto& offsets = mesh_offsets[instance.mesh.value];
+
+            u32 level = view ? SelectLod(mesh, instance, *view) : 0;
+            if (level == instance_lods[i]) {
+                for (auto& sub_mesh : mesh.sub_meshes) {
+                    (sub_mesh.index_type == nova::IndexType::U16 ? indirect_u16_count : indirect_count)++;
+                    draw_index++;
+                }
+                continue;
+            }
+            instance_lods[i] = level;
+
+            for (auto& sub_mesh : mesh.sub_meshes) {
+                u32 first_index = sub_mesh.first_index;
+                u32 index_count = sub_mesh.index_count;
+                if (level && !sub_mesh.lods.empty()) {
+                    auto& lod = sub_mesh.lods[std::min(level, u32(sub_mesh.lods.size())) - 1];
+                    first_index = lod.first_index;
+                    index_count = lod.index_count;
+                }
+
+                if (sub_mesh.index_type == nova::IndexType::U16) {
+                    indirect_u16_buffer.Set<VkDrawIndexedIndirectCommand>({{
+                        .indexCount = index_count,
+                        .instanceCount = 1,
+                        .firstIndex = offsets.first_index_u16 + first_index,
+                        .vertexOffset = offsets.vertex_offset + i32(sub_mesh.vertex_offset),
+                        .firstInstance = draw_index,
+                    }}, indirect_u16_count++);
+                } else {
+                    indirect_buffer.Set<VkDrawIndexedIndirectCommand>({{
+                        .indexCount = index_count,
+                        .instanceCount = 1,
+                        .firstIndex = offsets.first_index + first_index,
+                        .vertexOffset = offsets.vertex_offset + i32(sub_mesh.vertex_offset),
+                        .firstInstance = draw_index,
+                    }}, indirect_count++);
+                }
+
+                draw_index++;
+            }
+        }
+    }
+
     void RasterRenderer::SetCamera(Vec3 position, Quat rotation, f32 aspect, f32 fov)
     {
+        view_pos = position;
+        view_fov = fov;
+
         auto proj = ProjInfReversedZRH(fov, aspect, 0.01f);
         auto pos_tform = glm::translate(glm::mat4(1.f), position);
         auto rot_tform = glm::mat4_cast(rotation);
@@ -202,6 +359,15 @@ namespace axiom
 
         auto size = target.GetExtent();
 
+        if (has_lods) {
+            LodView view {
+                .position = view_pos,
+                .fov = view_fov,
+                .viewport_height = f32(size.y),
+            };
+            WriteDraws(&view);
+        }
+
         cmd.ResetGraphicsState();
         cmd.SetBlendState({ true, false });
         cmd.SetViewports({{{0, size.y}, Vec2I(size.x, -i32(size.y))}}, true);
@@ -215,19 +381,27 @@ namespace axiom
             u64  shading_attributes;
             u64           instances;
             Mat4          view_proj;
+            u32 quantised_positions;
         };
 
         cmd.BeginRendering({{}, size}, {target}, depth_image);
         cmd.ClearColor(0, Vec4(Vec3(0.2f), 1.f), Vec2(size));
         cmd.ClearDepth(0.f, Vec2(size));
-        cmd.BindIndexBuffer(index_buffer, nova::IndexType::U32);
         cmd.PushConstants(PushConstants {
             .position_attributes = position_attribute_buffer.GetAddress(),
             .shading_attributes = shading_attribute_buffer.GetAddress(),
             .instances = transform_buffer.GetAddress(),
             .view_proj = view_proj,
+            .quantised_positions = quantised_positions,
         });
-        cmd.DrawIndexedIndirect(indirect_buffer, 0, indirect_count, sizeof(VkDrawIndexedIndirectCommand));
+        if (indirect_count) {
+            cmd.BindIndexBuffer(index_buffer, nova::IndexType::U32);
+            cmd.DrawIndexedIndirect(indirect_buffer, 0, indirect_count, sizeof(VkDrawIndexedIndirectCommand));
+        }
+        if (indirect_u16_count) {
+            cmd.BindIndexBuffer(index_u16_buffer, nova::IndexType::U16);
+            cmd.DrawIndexedIndirect(indirect_u16_buffer, 0, indirect_u16_count, sizeof(VkDrawIndexedIndirectCommand));
+        }
         cmd.EndRendering();
     }
 }
\ No newline at end of file
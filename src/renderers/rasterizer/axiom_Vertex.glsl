@@ -1,6 +1,8 @@
 #extension GL_EXT_scalar_block_layout  : require
 #extension GL_EXT_buffer_reference2    : require
 #extension GL_EXT_nonuniform_qualifier : require
+#extension GL_EXT_shader_explicit_arithmetic_types_int16 : require
+#extension GL_EXT_shader_explicit_arithmetic_types_int64 : require
 
 #include "src/scene/runtime/axiom_Attributes.glsl"
 
@@ -8,13 +10,17 @@ layout(buffer_reference, scalar, buffer_reference_align = 4) readonly buffer Pos
     vec3 position;
 };
 
+layout(buffer_reference, scalar, buffer_reference_align = 2) readonly buffer QuantisedPosAttrib {
+    u16vec3 position;
+};
+
 layout(buffer_reference, scalar, buffer_reference_align = 4) readonly buffer ShadingAttributes {
     axiom_TangentSpace tangentSpace;
     axiom_TexCoords       texCoords;
 };
 
 layout(buffer_reference, scalar, buffer_reference_align = 4) readonly buffer Instance {
-    mat4 transform;
+    mat4x3 transform;
 };
 
 layout(push_constant, scalar) readonly uniform pc_ {
@@ -22,16 +28,24 @@ layout(push_constant, scalar) readonly uniform pc_ {
     ShadingAttributes shadingAttributes;
     Instance                  instances;
     mat4                       viewProj;
+    uint            quantisedPositions;
 } pc;
 
 layout(location = 0) out vec3 outPosition;
 
 void main()
 {
-    PosAttrib p = pc.posAttribs[gl_VertexIndex];
+    // Quantised positions are dequantised by the per draw transform
+
+    vec3 position;
+    if (pc.quantisedPositions != 0) {
+        position = vec3(QuantisedPosAttrib(uint64_t(pc.posAttribs))[gl_VertexIndex].position);
+    } else {
+        position = pc.posAttribs[gl_VertexIndex].position;
+    }
     Instance instance = pc.instances[gl_InstanceIndex];
 
-    vec4 worldPos = instance.transform * vec4(p.position, 1);
-    outPosition = vec3(worldPos);
-    gl_Position = pc.viewProj * worldPos;
+    vec3 worldPos = instance.transform * vec4(position, 1);
+    outPosition = worldPos;
+    gl_Position = pc.viewProj * vec4(worldPos, 1);
 }
\ No newline at end of file
@@ -2,6 +2,56 @@
 
 namespace axiom
 {
+    namespace
+    {
+        // Names are views of the map keys, which are stable across rehashing
+        struct PropertyRegistry
+        {
+            std::mutex                            mutex;
+            std::unordered_map<std::string, u32>    ids;
+            std::vector<std::string_view>         names;
+        };
+
+        PropertyRegistry& GetPropertyRegistry()
+        {
+            static PropertyRegistry registry;
+            return registry;
+        }
+    }
+
+    scene_ir::PropertyKey scene_ir::InternProperty(std::string_view name)
+    {
+        for (u32 i = 0; i < property::WellKnownCount; ++i) {
+            if (property::WellKnownNames[i] == name) {
+                return { i };
+            }
+        }
+
+        auto& registry = GetPropertyRegistry();
+        std::scoped_lock lock{ registry.mutex };
+
+        auto[iter, inserted] = registry.ids.try_emplace(std::string(name), property::WellKnownCount + u32(registry.names.size()));
+        if (inserted) {
+            registry.names.emplace_back(iter->first);
+        }
+
+        return { iter->second };
+    }
+
+    std::string_view scene_ir::GetPropertyName(PropertyKey key)
+    {
+        if (key.id < property::WellKnownCount) {
+            return property::WellKnownNames[key.id];
+        }
+
+        auto& registry = GetPropertyRegistry();
+        std::scoped_lock lock{ registry.mutex };
+
+        return key.id - property::WellKnownCount < registry.names.size()
+            ? registry.names[key.id - property::WellKnownCount]
+            : "invalid"sv;
+    }
+
     void scene_ir::Scene::Debug()
     {
         auto WriteHeader = [&](std::string_view header) {
@@ -59,7 +109,7 @@ namespace axiom
         for (auto& material: materials) {
             NOVA_LOG("Material[{}]", &material - materials.data());
             for (auto& property : material.properties) {
-                NOVA_LOG("  {}:", property.name);
+                NOVA_LOG("  {}:", GetPropertyName(property.key));
                 std::visit(nova::Overloads {
                     [&](const TextureSwizzle& value) {
                         NOVA_LOG("    Texture: {}", value.texture_idx);
@@ -90,7 +140,7 @@ namespace axiom
 
         for (auto& instance : instances) {
             NOVA_LOG("Instance[{}]", &instance - instances.data());
-            NOVA_LOG("  Mesh[{}]", instance.mesh_idx);
+            NOVA_LOG("  Mesh[{}] (count = {})", instance.mesh_idx, instance.mesh_count);
             NOVA_LOG("  Transform:");
             auto& M = instance.transform;
             NOVA_LOG("    {:12.5f} {:12.5f} {:12.5f} {:12.5f}", M[0][0], M[1][0], M[2][0], M[3][0]);
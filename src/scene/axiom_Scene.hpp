@@ -43,19 +43,54 @@ namespace axiom
             std::array<i8, 4> channels{ -1, -1, -1, -1 };
         };
 
+        // Interned property name. Well known names in scene_ir::property have fixed
+        // keys, any other name is assigned a key on first use by InternProperty
+        struct PropertyKey
+        {
+            u32 id = UINT32_MAX;
+
+            bool operator==(const PropertyKey&) const noexcept = default;
+        };
+
+        // Well known properties as (key, name). Keys are assigned in order
+#define AXIOM_WELL_KNOWN_PROPERTIES(X)       \
+        X(BaseColor,     "base_color")       \
+        X(Alpha,         "alpha")            \
+        X(Normal,        "normal")           \
+        X(Emissive,      "emissive")         \
+        X(Metallic,      "metallic")         \
+        X(Roughness,     "roughness")        \
+        X(AlphaCutoff,   "alpha_cutoff")     \
+        X(AlphaMask,     "alpha_blend")      \
+        X(SpecularColor, "specular_color")   \
+        X(Specular,      "specular")         \
+        X(Transmission,  "transmission")
+
         namespace property {
-            constexpr std::string_view BaseColor     = "base_color"sv;
-            constexpr std::string_view Alpha         = "alpha"sv;
-            constexpr std::string_view Normal        = "normal"sv;
-            constexpr std::string_view Emissive      = "emissive"sv;
-            constexpr std::string_view Metallic      = "metallic"sv;
-            constexpr std::string_view Roughness     = "roughness"sv;
-            constexpr std::string_view AlphaCutoff   = "alpha_cutoff"sv;
-            constexpr std::string_view AlphaMask     = "alpha_blend"sv;
-            constexpr std::string_view SpecularColor = "specular_color"sv;
-            constexpr std::string_view Specular      = "specular"sv;
+            enum class WellKnown : u32
+            {
+#define AXIOM_PROPERTY_ENUM(key, name) key,
+                AXIOM_WELL_KNOWN_PROPERTIES(AXIOM_PROPERTY_ENUM)
+#undef AXIOM_PROPERTY_ENUM
+                Count,
+            };
+
+#define AXIOM_PROPERTY_KEY(key, name) constexpr PropertyKey key { u32(WellKnown::key) };
+            AXIOM_WELL_KNOWN_PROPERTIES(AXIOM_PROPERTY_KEY)
+#undef AXIOM_PROPERTY_KEY
+
+            constexpr u32 WellKnownCount = u32(WellKnown::Count);
+
+            constexpr std::array<std::string_view, WellKnownCount> WellKnownNames {
+#define AXIOM_PROPERTY_NAME(key, name) std::string_view(name),
+                AXIOM_WELL_KNOWN_PROPERTIES(AXIOM_PROPERTY_NAME)
+#undef AXIOM_PROPERTY_NAME
+            };
         }
 
+        PropertyKey InternProperty(std::string_view name);
+        std::string_view GetPropertyName(PropertyKey key);
+
         using PropertyValue = std::variant<
             TextureSwizzle,
             bool,
@@ -67,19 +102,66 @@ namespace axiom
 
         struct Property
         {
-            std::string_view name;
-            PropertyValue   value;
+            PropertyKey     key;
+            PropertyValue value;
+        };
+
+        template<class ValueT, class VariantT>
+        struct VariantIndex;
+
+        template<class ValueT, class... Ts>
+        struct VariantIndex<ValueT, std::variant<Ts...>>
+        {
+            static constexpr usz Value = [] {
+                usz index = 0;
+                bool found = false;
+                ((found = found || std::is_same_v<ValueT, Ts>, index += !found), ...);
+                return index;
+            }();
         };
 
         struct Material
         {
+            // A key may appear once per value type, e.g. a texture and a constant factor.
+            // Add through SetProperty, which maintains the well known property slots
             std::vector<Property> properties;
 
+            // Index + 1 into properties for each well known key and value type, 0 if absent
+            std::array<std::array<u32, std::variant_size_v<PropertyValue>>, property::WellKnownCount> slots = {};
+
+            // Adds a property, or replaces the value of the same key and type
+            void SetProperty(PropertyKey key, PropertyValue value)
+            {
+                if (key.id < property::WellKnownCount) {
+                    auto& slot = slots[key.id][value.index()];
+                    if (slot) {
+                        properties[slot - 1].value = std::move(value);
+                    } else {
+                        properties.emplace_back(key, std::move(value));
+                        slot = u32(properties.size());
+                    }
+                    return;
+                }
+
+                for (auto& property : properties) {
+                    if (property.key == key && property.value.index() == value.index()) {
+                        property.value = std::move(value);
+                        return;
+                    }
+                }
+                properties.emplace_back(key, std::move(value));
+            }
+
             template<class ValueT>
-            ValueT* GetProperty(std::string_view type)
+            ValueT* GetProperty(PropertyKey key)
             {
+                if (key.id < property::WellKnownCount) {
+                    u32 slot = slots[key.id][VariantIndex<ValueT, PropertyValue>::Value];
+                    return slot ? &std::get<ValueT>(properties[slot - 1].value) : nullptr;
+                }
+
                 for (auto& property : properties) {
-                    if (property.name == type
+                    if (property.key == key
                             && std::holds_alternative<ValueT>(property.value)) {
                         return &std::get<ValueT>(property.value);
                     }
@@ -87,6 +169,12 @@ namespace axiom
 
                 return nullptr;
             }
+
+            template<class ValueT>
+            const ValueT* GetProperty(PropertyKey key) const
+            {
+                return const_cast<Material*>(this)->GetProperty<ValueT>(key);
+            }
         };
 
         struct Mesh
@@ -98,10 +186,22 @@ namespace axiom
             u32             material_idx = InvalidIndex;
         };
 
+        // Source node hierarchy. Parents precede their children
+        struct Node
+        {
+            u32   parent = InvalidIndex;
+            Mat4x3 transform;
+        };
+
         struct Instance
         {
+            // Instances a contiguous group of meshes, e.g. all primitives of a source mesh
             u32   mesh_idx = InvalidIndex;
-            Mat4 transform;
+            u32 mesh_count = 1;
+
+            // World space, flattened from node_idx when present
+            Mat4x3 transform;
+            u32     node_idx = InvalidIndex;
         };
 
         struct Scene
@@ -109,6 +209,7 @@ namespace axiom
             std::vector<Texture>   textures;
             std::vector<Material> materials;
             std::vector<Mesh>        meshes;
+            std::vector<Node>         nodes;
             std::vector<Instance> instances;
 
             void Clear()
@@ -116,6 +217,7 @@ namespace axiom
                 textures.clear();
                 materials.clear();
                 meshes.clear();
+                nodes.clear();
                 instances.clear();
             }
 
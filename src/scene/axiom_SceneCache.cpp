@@ -0,0 +1,297 @@
+#include "axiom_SceneCache.hpp"
+
+#include <nova/core/nova_Containers.hpp>
+#include <nova/core/nova_Files.hpp>
+
+#include <thread>
+
+namespace axiom
+{
+    namespace
+    {
+        // Increment when the layout of scene_ir or the cache changes
+        constexpr u32 ImportCacheVersion = 4;
+
+        constexpr u64 ImportCacheMagic = 0x00545250'4D495841; // "AXIMPRT"
+
+        const std::filesystem::path ImportCacheDir = "cache";
+
+        struct CacheHeader
+        {
+            u64            magic;
+            u32          version;
+            u32 dependency_count;
+            u64          options;
+            u32    texture_count;
+            u32   material_count;
+            u32       mesh_count;
+            u32       node_count;
+            u32   instance_count;
+        };
+
+        struct FileStamp
+        {
+            u64       size;
+            i64 write_time;
+
+            bool operator==(const FileStamp&) const = default;
+        };
+
+        // Missing files produce a stamp that never matches an existing file
+        FileStamp GetFileStamp(const std::filesystem::path& path)
+        {
+            std::error_code ec;
+            auto file_size = std::filesystem::file_size(path, ec);
+            if (ec) {
+                return { UINT64_MAX, INT64_MIN };
+            }
+
+            auto write_time = std::filesystem::last_write_time(path, ec);
+            if (ec) {
+                return { UINT64_MAX, INT64_MIN };
+            }
+
+            return { u64(file_size), i64(write_time.time_since_epoch().count()) };
+        }
+
+        void WriteString(nova::File& file, std::string_view str)
+        {
+            file.Write(u64(str.size()));
+            file.Write(str.data(), str.size());
+        }
+
+        std::string ReadString(nova::File& file)
+        {
+            u64 length;
+            file.Read(length);
+            std::string str(length, '\0');
+            file.Read(str.data(), length);
+            return str;
+        }
+
+        template<class T>
+        void WriteVector(nova::File& file, const std::vector<T>& v)
+        {
+            file.Write(u64(v.size()));
+            file.Write(v.data(), v.size() * sizeof(T));
+        }
+
+        template<class T>
+        void ReadVector(nova::File& file, std::vector<T>& v)
+        {
+            u64 size;
+            file.Read(size);
+            v.resize(size);
+            file.Read(v.data(), size * sizeof(T));
+        }
+
+        template<usz I = 0, class VariantT>
+        void ReadVariant(nova::File& file, u32 index, VariantT& variant)
+        {
+            if constexpr (I < std::variant_size_v<VariantT>) {
+                if (index == I) {
+                    std::variant_alternative_t<I, VariantT> value;
+                    file.Read(value);
+                    variant = value;
+                } else {
+                    ReadVariant<I + 1>(file, index, variant);
+                }
+            }
+        }
+    }
+
+    scene_ir::ImportCache::ImportCache(const std::filesystem::path& _source, std::string_view importer, u64 _options)
+        : source(std::filesystem::absolute(_source))
+        , options(_options)
+    {
+        // Named by source and importer only, so that a changed source replaces its previous entry
+
+        auto source_path = source.string();
+
+        std::array<u64, 2> key {
+            ankerl::unordered_dense::detail::wyhash::hash(source_path.data(), source_path.size()),
+            ankerl::unordered_dense::detail::wyhash::hash(importer.data(), importer.size()),
+        };
+
+        path = ImportCacheDir / std::format("scene${:016x}",
+            ankerl::unordered_dense::detail::wyhash::hash(key.data(), sizeof(key)));
+    }
+
+    bool scene_ir::ImportCache::Read(Scene& out_scene) const
+    {
+        if (!std::filesystem::exists(path)) {
+            return false;
+        }
+
+        nova::File file{ path.string().c_str() };
+
+        CacheHeader header;
+        file.Read(header);
+        if (header.magic != ImportCacheMagic || header.version != ImportCacheVersion || header.options != options) {
+            return false;
+        }
+
+        for (u32 i = 0; i < header.dependency_count; ++i) {
+            auto dependency = ReadString(file);
+            FileStamp stamp;
+            file.Read(stamp);
+            if (stamp != GetFileStamp(dependency)) {
+                return false;
+            }
+        }
+
+        Scene scene;
+
+        scene.textures.resize(header.texture_count);
+        for (auto& texture : scene.textures) {
+            u32 type;
+            file.Read(type);
+            switch (type) {
+                break;case 0: {
+                    ImageBuffer buffer;
+                    ReadVector(file, buffer.data);
+                    file.Read(buffer.size);
+                    file.Read(buffer.format);
+                    texture.data = std::move(buffer);
+                }
+                break;case 1: {
+                    ImageFileBuffer buffer;
+                    ReadVector(file, buffer.data);
+                    texture.data = std::move(buffer);
+                }
+                break;case 2: {
+                    texture.data = ImageFileURI(ReadString(file));
+                }
+                break;default: return false;
+            }
+        }
+
+        scene.materials.resize(header.material_count);
+        for (auto& material : scene.materials) {
+            u32 property_count;
+            file.Read(property_count);
+            for (u32 i = 0; i < property_count; ++i) {
+                Property property;
+
+                u32 name_length;
+                file.Read(name_length);
+                std::string name(name_length, '\0');
+                file.Read(name.data(), name_length);
+
+                // Keys are only stable within a process, so properties are stored by name
+                property.key = InternProperty(name);
+
+                u32 index;
+                file.Read(index);
+                if (index >= std::variant_size_v<PropertyValue>) {
+                    return false;
+                }
+                ReadVariant(file, index, property.value);
+                material.SetProperty(property.key, std::move(property.value));
+            }
+        }
+
+        scene.meshes.resize(header.mesh_count);
+        for (auto& mesh : scene.meshes) {
+            ReadVector(file, mesh.positions);
+            ReadVector(file, mesh.normals);
+            ReadVector(file, mesh.tex_coords);
+            ReadVector(file, mesh.indices);
+            file.Read(mesh.material_idx);
+        }
+
+        scene.nodes.resize(header.node_count);
+        file.Read(scene.nodes.data(), scene.nodes.size() * sizeof(Node));
+
+        scene.instances.resize(header.instance_count);
+        file.Read(scene.instances.data(), scene.instances.size() * sizeof(Instance));
+
+        out_scene = std::move(scene);
+
+        return true;
+    }
+
+    void scene_ir::ImportCache::Write(const Scene& scene, std::span<const std::filesystem::path> dependencies) const
+    {
+        std::filesystem::create_directories(path.parent_path());
+
+        // Written to a temporary file and renamed, so that interrupted writes are never read back
+
+        auto temp_path = path;
+        temp_path += std::format(".{:x}", std::hash<std::thread::id>{}(std::this_thread::get_id()));
+
+        {
+            nova::File file{ temp_path.string().c_str(), true };
+
+            file.Write(CacheHeader {
+                .magic = ImportCacheMagic,
+                .version = ImportCacheVersion,
+                .dependency_count = u32(dependencies.size() + 1),
+                .options = options,
+                .texture_count = u32(scene.textures.size()),
+                .material_count = u32(scene.materials.size()),
+                .mesh_count = u32(scene.meshes.size()),
+                .node_count = u32(scene.nodes.size()),
+                .instance_count = u32(scene.instances.size()),
+            });
+
+            auto WriteDependency = [&](const std::filesystem::path& dependency) {
+                auto dependency_path = std::filesystem::absolute(dependency);
+                WriteString(file, dependency_path.string());
+                file.Write(GetFileStamp(dependency_path));
+            };
+
+            WriteDependency(source);
+            for (auto& dependency : dependencies) {
+                WriteDependency(dependency);
+            }
+
+            for (auto& texture : scene.textures) {
+                file.Write(u32(texture.data.index()));
+                std::visit(nova::Overloads {
+                    [&](const ImageBuffer& buffer) {
+                        WriteVector(file, buffer.data);
+                        file.Write(buffer.size);
+                        file.Write(buffer.format);
+                    },
+                    [&](const ImageFileBuffer& buffer) {
+                        WriteVector(file, buffer.data);
+                    },
+                    [&](const ImageFileURI& uri) {
+                        // Importers produce paths relative to the working directory, which
+                        // may differ when the entry is read back
+                        WriteString(file, std::filesystem::absolute(uri.uri).string());
+                    },
+                }, texture.data);
+            }
+
+            for (auto& material : scene.materials) {
+                file.Write(u32(material.properties.size()));
+                for (auto& property : material.properties) {
+                    auto name = GetPropertyName(property.key);
+                    file.Write(u32(name.size()));
+                    file.Write(name.data(), name.size());
+                    file.Write(u32(property.value.index()));
+                    std::visit([&](const auto& value) { file.Write(value); }, property.value);
+                }
+            }
+
+            for (auto& mesh : scene.meshes) {
+                WriteVector(file, mesh.positions);
+                WriteVector(file, mesh.normals);
+                WriteVector(file, mesh.tex_coords);
+                WriteVector(file, mesh.indices);
+                file.Write(mesh.material_idx);
+            }
+
+            file.Write(scene.nodes.data(), scene.nodes.size() * sizeof(Node));
+            file.Write(scene.instances.data(), scene.instances.size() * sizeof(Instance));
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(temp_path, path, ec);
+        if (ec) {
+            std::filesystem::remove(temp_path, ec);
+        }
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "axiom_Scene.hpp"
+
+namespace axiom
+{
+    namespace scene_ir
+    {
+        // Binary cache of imported scenes, so that importers can skip parsing sources
+        // that have not changed since they were last imported. Each source and importer
+        // pair has a single entry, replaced in place on every write. An entry is only
+        // valid for the options hash it was written with, and while the size and
+        // modification time of the source and every recorded dependency are unchanged
+        struct ImportCache
+        {
+            std::filesystem::path   path;
+            std::filesystem::path source;
+            u64                  options;
+
+            ImportCache(const std::filesystem::path& source, std::string_view importer, u64 options = 0);
+
+            // Returns false if no valid entry exists, scene is left unchanged
+            bool Read(Scene& scene) const;
+
+            // Dependencies are any files other than the source read by the import, such
+            // as external buffers or material libraries
+            void Write(const Scene& scene, std::span<const std::filesystem::path> dependencies = {}) const;
+        };
+    }
+}
@@ -1,9 +1,32 @@
 #include "axiom_AssimpImporter.hpp"
 
+#include <scene/axiom_SceneCache.hpp>
+
 #include <nova/core/nova_Containers.hpp>
 
+#include <assimp/DefaultIOSystem.h>
+
 namespace axiom
 {
+    namespace
+    {
+        // Records every file opened by an import, such as .mtl libraries, so that they
+        // can be tracked as import cache dependencies
+        struct RecordingIOSystem : Assimp::DefaultIOSystem
+        {
+            std::vector<std::filesystem::path> opened;
+
+            Assimp::IOStream* Open(const char* file, const char* mode) override
+            {
+                auto* stream = Assimp::DefaultIOSystem::Open(file, mode);
+                if (stream) {
+                    opened.emplace_back(file);
+                }
+                return stream;
+            }
+        };
+    }
+
     void AssimpImporter::Reset()
     {
         scene.Clear();
@@ -23,8 +46,22 @@ namespace axiom
         ai_flags |= aiProcess_TransformUVCoords;
 
         dir = path.parent_path();
+
+        scene_ir::ImportCache cache{ path, "assimp", ai_flags };
+        if (cache.Read(scene)) {
+            NOVA_LOG("Loaded [{}] from import cache", path.string());
+            return std::move(scene);
+        }
+
+        // Owned by the importer until replaced
+        auto* io_system = new RecordingIOSystem;
+        assimp.SetIOHandler(io_system);
+
         asset = assimp.ReadFile(path.string(), ai_flags);
 
+        auto dependencies = std::move(io_system->opened);
+        assimp.SetIOHandler(nullptr);
+
         if (!asset) {
             NOVA_THROW("ASSIMP: Error loading [{}]: {}", path.string(), assimp.GetErrorString());
         }
@@ -52,10 +89,12 @@ namespace axiom
 
         // Nodes
 
-        ProcessNode(asset->mRootNode, Mat4(1.f));
+        ProcessNode(asset->mRootNode, Mat4(1.f), scene_ir::InvalidIndex);
 
         // ----
 
+        cache.Write(scene, dependencies);
+
         return std::move(scene);
     }
 
@@ -267,10 +306,17 @@ namespace axiom
         }
     }
 
-    void AssimpImporter::ProcessNode(aiNode* node, Mat4 parent_transform)
+    void AssimpImporter::ProcessNode(aiNode* node, Mat4 parent_transform, u32 parent_node)
     {
         auto transform = std::bit_cast<Mat4>(node->mTransformation);
         transform = glm::transpose(transform);
+
+        u32 ir_node = u32(scene.nodes.size());
+        scene.nodes.push_back(scene_ir::Node {
+            .parent = parent_node,
+            .transform = Mat4x3(transform),
+        });
+
         transform = parent_transform * transform;
 
         for (u32 i = 0; i < node->mNumMeshes; ++i) {
@@ -279,12 +325,13 @@ namespace axiom
 
             scene.instances.push_back(scene_ir::Instance {
                 .mesh_idx = node->mMeshes[i],
-                .transform = transform,
+                .transform = Mat4x3(transform),
+                .node_idx = ir_node,
             });
         }
 
         for (u32 i = 0; i < node->mNumChildren; ++i) {
-            ProcessNode(node->mChildren[i], transform);
+            ProcessNode(node->mChildren[i], transform, ir_node);
         }
     }
 }
\ No newline at end of file
@@ -30,7 +30,7 @@ namespace axiom
         void ProcessTexture(u32 texture_index);
         void ProcessMaterial(u32 material_index);
         void ProcessMesh(u32 mesh_index);
-        void ProcessNode(aiNode* node, Mat4 parent_transform);
+        void ProcessNode(aiNode* node, Mat4 parent_transform, u32 parent_node);
 
         scene_ir::Scene Import(const std::filesystem::path& path);
     };
@@ -1,5 +1,7 @@
 #include "axiom_FbxImporter.hpp"
 
+#include <scene/axiom_SceneCache.hpp>
+
 #include <ufbx.h>
 
 namespace axiom
@@ -25,7 +27,18 @@ namespace axiom
         Reset();
         dir = path.parent_path();
 
-        ufbx_load_opts opts{};
+        // Zeroed rather than value initialized so that padding hashes consistently
+
+        ufbx_load_opts opts;
+        std::memset(&opts, 0, sizeof(opts));
+
+        scene_ir::ImportCache cache{ path, "fbx",
+            ankerl::unordered_dense::detail::wyhash::hash(&opts, sizeof(opts)) };
+        if (cache.Read(scene)) {
+            NOVA_LOG("Loaded [{}] from import cache", path.string());
+            return std::move(scene);
+        }
+
         ufbx_error error;
         NOVA_LOGEXPR(path.string());
         fbx = ufbx_load_file(path.string().c_str(), &opts, &error);
@@ -50,7 +63,9 @@ namespace axiom
             }
         }
 
-        ProcessNode(fbx->root_node, Mat4(1.f));
+        ProcessNode(fbx->root_node, Mat4(1.f), scene_ir::InvalidIndex);
+
+        cache.Write(scene);
 
         return std::move(scene);
     }
@@ -83,19 +98,19 @@ namespace axiom
         material_indices[in_material] = mat_idx;
 
         auto AddProperty = [&](
-                std::string_view name,
+                scene_ir::PropertyKey key,
                 const ufbx_material_map& map) {
 
             if (map.texture_enabled && map.texture) {
-                out_material.properties.emplace_back(name, scene_ir::TextureSwizzle{ .texture_idx = u32(texture_indices[map.texture]) });
+                out_material.SetProperty(key, scene_ir::TextureSwizzle{ .texture_idx = u32(texture_indices[map.texture]) });
             }
 
             if (map.has_value) {
                 switch (map.value_components) {
-                    break;case 1: out_material.properties.emplace_back(name, f32(map.value_real));
-                    break;case 2: out_material.properties.emplace_back(name, Vec2(f32(map.value_vec2.x), f32(map.value_vec2.y)));
-                    break;case 3: out_material.properties.emplace_back(name, Vec3(f32(map.value_vec3.x), f32(map.value_vec3.y), f32(map.value_vec3.z)));
-                    break;case 4: out_material.properties.emplace_back(name, Vec4(f32(map.value_vec4.x), f32(map.value_vec4.y), f32(map.value_vec4.z), f32(map.value_vec4.w)));
+                    break;case 1: out_material.SetProperty(key, f32(map.value_real));
+                    break;case 2: out_material.SetProperty(key, Vec2(f32(map.value_vec2.x), f32(map.value_vec2.y)));
+                    break;case 3: out_material.SetProperty(key, Vec3(f32(map.value_vec3.x), f32(map.value_vec3.y), f32(map.value_vec3.z)));
+                    break;case 4: out_material.SetProperty(key, Vec4(f32(map.value_vec4.x), f32(map.value_vec4.y), f32(map.value_vec4.z), f32(map.value_vec4.w)));
                     break;default: NOVA_THROW("Invalid number of value components: {}", map.value_components);
                 }
             }
@@ -112,7 +127,7 @@ namespace axiom
 
         AddProperty(scene_ir::property::SpecularColor, in_material->fbx.specular_color);
 
-        out_material.properties.emplace_back(scene_ir::property::AlphaMask, in_material->features.opacity.enabled);
+        out_material.SetProperty(scene_ir::property::AlphaMask, in_material->features.opacity.enabled);
     }
 
     void FbxImporter::ProcessMesh(u32 fbx_mesh_idx, u32 prim_idx)
@@ -180,7 +195,7 @@ namespace axiom
         }
     }
 
-    void FbxImporter::ProcessNode(ufbx_node* in_node, Mat4 parent_transform)
+    void FbxImporter::ProcessNode(ufbx_node* in_node, Mat4 parent_transform, u32 parent_node)
     {
         auto fbx_tform = in_node->local_transform;
         Mat4 transform = Mat4(1.f);
@@ -193,6 +208,13 @@ namespace axiom
             auto s = glm::scale(Mat4(1.f), Vec3(f32(ts.x), f32(ts.y), f32(ts.z)));
             transform = t * r * s;
         }
+
+        u32 ir_node = u32(scene.nodes.size());
+        scene.nodes.push_back(scene_ir::Node {
+            .parent = parent_node,
+            .transform = Mat4x3(transform),
+        });
+
         transform = parent_transform * transform;
 
         if (in_node->mesh) {
@@ -202,16 +224,18 @@ namespace axiom
             }
 
             auto[mesh_idx, mesh_count] = fbx_mesh_offsets[u32(std::distance(fbx->meshes.begin(), mesh_iter))];
-            for (u32 i = 0; i < mesh_count; ++i) {
+            if (mesh_count) {
                 scene.instances.emplace_back(scene_ir::Instance {
-                    .mesh_idx = mesh_idx + i,
-                    .transform = transform,
+                    .mesh_idx = mesh_idx,
+                    .mesh_count = mesh_count,
+                    .transform = Mat4x3(transform),
+                    .node_idx = ir_node,
                 });
             }
         }
 
         for (auto* child : in_node->children) {
-            ProcessNode(child, transform);
+            ProcessNode(child, transform, ir_node);
         }
     }
 }
\ No newline at end of file
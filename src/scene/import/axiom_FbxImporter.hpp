@@ -56,6 +56,6 @@ namespace axiom
         void ProcessTexture(u32 tex_idx);
         void ProcessMaterial(u32 mat_idx);
         void ProcessMesh(u32 fbx_mesh_idx, u32 prim_idx);
-        void ProcessNode(ufbx_node* node, Mat4 parent_transform);
+        void ProcessNode(ufbx_node* node, Mat4 parent_transform, u32 parent_node);
     };
 }
\ No newline at end of file
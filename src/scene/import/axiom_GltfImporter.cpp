@@ -1,10 +1,14 @@
 #include "axiom_GltfImporter.hpp"
 
+#include <scene/axiom_SceneCache.hpp>
+
 #include <nova/core/nova_Containers.hpp>
 
 #include <fastgltf/parser.hpp>
 #include <fastgltf/glm_element_traits.hpp>
 
+#include <fstream>
+
 namespace axiom
 {
     void GltfImporter::Reset()
@@ -18,7 +22,7 @@ namespace axiom
         Reset();
         dir = path.parent_path();
 
-        fastgltf::Parser parser {
+        constexpr auto GltfExtensions =
               fastgltf::Extensions::KHR_texture_transform
             | fastgltf::Extensions::KHR_texture_basisu
             | fastgltf::Extensions::MSFT_texture_dds
@@ -34,17 +38,28 @@ namespace axiom
             | fastgltf::Extensions::KHR_materials_clearcoat
             | fastgltf::Extensions::KHR_materials_emissive_strength
             | fastgltf::Extensions::KHR_materials_sheen
-            | fastgltf::Extensions::KHR_materials_unlit
-        };
+            | fastgltf::Extensions::KHR_materials_unlit;
 
-        fastgltf::GltfDataBuffer data;
-        data.loadFromFile(path);
+        // External buffers are loaded below instead of by the parser, so that their
+        // paths can be recorded as import cache dependencies
 
         constexpr auto GltfOptions =
               fastgltf::Options::DontRequireValidAssetMember
             | fastgltf::Options::AllowDouble
-            | fastgltf::Options::LoadGLBBuffers
-            | fastgltf::Options::LoadExternalBuffers;
+            | fastgltf::Options::LoadGLBBuffers;
+
+        std::array<u64, 2> options { u64(GltfExtensions), u64(GltfOptions) };
+        scene_ir::ImportCache cache{ path, "gltf",
+            ankerl::unordered_dense::detail::wyhash::hash(options.data(), sizeof(options)) };
+        if (cache.Read(scene)) {
+            NOVA_LOG("Loaded [{}] from import cache", path.string());
+            return std::move(scene);
+        }
+
+        fastgltf::Parser parser{ GltfExtensions };
+
+        fastgltf::GltfDataBuffer data;
+        data.loadFromFile(path);
 
         auto type = fastgltf::determineGltfFileType(&data);
 
@@ -58,6 +73,26 @@ namespace axiom
 
         asset = std::make_unique<fastgltf::Asset>(std::move(res.get()));
 
+        std::vector<std::filesystem::path> dependencies;
+        for (auto& buffer : asset->buffers) {
+            if (auto uri = std::get_if<fastgltf::sources::URI>(&buffer.data)) {
+                auto buffer_path = dir / std::filesystem::path(uri->uri.path());
+
+                std::ifstream file(buffer_path, std::ios::binary);
+                file.seekg(std::streamoff(uri->fileByteOffset));
+
+                fastgltf::sources::Vector bytes;
+                bytes.bytes.resize(buffer.byteLength);
+                bytes.mimeType = uri->mimeType;
+                if (!file.read(reinterpret_cast<char*>(bytes.bytes.data()), std::streamsize(buffer.byteLength))) {
+                    NOVA_THROW("Error loading [{}] Failed to read buffer [{}]", path.string(), buffer_path.string());
+                }
+
+                buffer.data = std::move(bytes);
+                dependencies.push_back(std::move(buffer_path));
+            }
+        }
+
         {
             NOVA_LOG("Validating...");
             auto error = fastgltf::validate(*asset);
@@ -86,18 +121,21 @@ namespace axiom
         gltf_mesh_offsets.resize(asset->meshes.size());
         for (u32 i = 0; i < asset->meshes.size(); ++i) {
             gltf_mesh_offsets[i].first = u32(scene.meshes.size());
-            gltf_mesh_offsets[i].second = u32(asset->meshes[i].primitives.size());
             for (u32 j = 0; j < asset->meshes[i].primitives.size(); ++j) {
                 ProcessMesh(i, j);
             }
+            // Unsupported primitives are skipped, so count what was emitted
+            gltf_mesh_offsets[i].second = u32(scene.meshes.size()) - gltf_mesh_offsets[i].first;
         }
 
         // Instances
 
         for (auto root_node_index : asset->scenes[asset->defaultScene.value()].nodeIndices) {
-            ProcessNode(root_node_index, Mat4(1.f));
+            ProcessNode(root_node_index, Mat4(1.f), scene_ir::InvalidIndex);
         }
 
+        cache.Write(scene, dependencies);
+
         return std::move(scene);
     }
 
@@ -153,28 +191,28 @@ namespace axiom
         auto& out_material = scene.materials[mat_idx];
 
         auto AddProperty = nova::Overloads {
-            [&](std::string_view name, fastgltf::Optional<fastgltf::TextureInfo>& texture) {
-                if (texture) out_material.properties.emplace_back(name, scene_ir::TextureSwizzle{ .texture_idx = u32(texture->textureIndex) }); },
-            [&](std::string_view name, fastgltf::Optional<fastgltf::NormalTextureInfo>& texture) {
-                if (texture) out_material.properties.emplace_back(name, scene_ir::TextureSwizzle{ .texture_idx = u32(texture->textureIndex) }); },
-            [&](std::string_view name, nova::Span<f32> values) {
+            [&](scene_ir::PropertyKey key, fastgltf::Optional<fastgltf::TextureInfo>& texture) {
+                if (texture) out_material.SetProperty(key, scene_ir::TextureSwizzle{ .texture_idx = u32(texture->textureIndex) }); },
+            [&](scene_ir::PropertyKey key, fastgltf::Optional<fastgltf::NormalTextureInfo>& texture) {
+                if (texture) out_material.SetProperty(key, scene_ir::TextureSwizzle{ .texture_idx = u32(texture->textureIndex) }); },
+            [&](scene_ir::PropertyKey key, nova::Span<f32> values) {
                 switch (values.size()) {
-                    break;case 1: out_material.properties.emplace_back(name, values[0]);
-                    break;case 2: out_material.properties.emplace_back(name, Vec2(values[0], values[1]));
-                    break;case 3: out_material.properties.emplace_back(name, Vec3(values[0], values[1], values[2]));
-                    break;case 4: out_material.properties.emplace_back(name, Vec4(values[0], values[1], values[2], values[3]));
+                    break;case 1: out_material.SetProperty(key, values[0]);
+                    break;case 2: out_material.SetProperty(key, Vec2(values[0], values[1]));
+                    break;case 3: out_material.SetProperty(key, Vec3(values[0], values[1], values[2]));
+                    break;case 4: out_material.SetProperty(key, Vec4(values[0], values[1], values[2], values[3]));
                     break;default: NOVA_THROW("Invalid number of values: {}", values.size());
                 }
             },
-            [&](std::string_view name, f32  scalar) { out_material.properties.emplace_back(name, scalar); },
-            [&](std::string_view name, i32  scalar) { out_material.properties.emplace_back(name, scalar); },
-            [&](std::string_view name, bool scalar) { out_material.properties.emplace_back(name, scalar); },
-            [&](std::string_view name, fastgltf::Optional<f32> scalar) {
-                if (scalar) out_material.properties.emplace_back(name, scalar.value()); },
-            [&](std::string_view name, fastgltf::Optional<i32> scalar) {
-                if (scalar) out_material.properties.emplace_back(name, scalar.value()); },
-            [&](std::string_view name, fastgltf::Optional<bool> scalar) {
-                if (scalar) out_material.properties.emplace_back(name, scalar.value()); },
+            [&](scene_ir::PropertyKey key, f32  scalar) { out_material.SetProperty(key, scalar); },
+            [&](scene_ir::PropertyKey key, i32  scalar) { out_material.SetProperty(key, scalar); },
+            [&](scene_ir::PropertyKey key, bool scalar) { out_material.SetProperty(key, scalar); },
+            [&](scene_ir::PropertyKey key, fastgltf::Optional<f32> scalar) {
+                if (scalar) out_material.SetProperty(key, scalar.value()); },
+            [&](scene_ir::PropertyKey key, fastgltf::Optional<i32> scalar) {
+                if (scalar) out_material.SetProperty(key, scalar.value()); },
+            [&](scene_ir::PropertyKey key, fastgltf::Optional<bool> scalar) {
+                if (scalar) out_material.SetProperty(key, scalar.value()); },
         };
 
         AddProperty(scene_ir::property::BaseColor, in_material.pbrData.baseColorTexture);
@@ -235,7 +273,7 @@ namespace axiom
         }
     }
 
-    void GltfImporter::ProcessNode(usz node_idx, Mat4 parent_transform)
+    void GltfImporter::ProcessNode(usz node_idx, Mat4 parent_transform, u32 parent_node)
     {
         auto& node = asset->nodes[node_idx];
 
@@ -251,20 +289,28 @@ namespace axiom
             transform = std::bit_cast<Mat4>(*m);
         }
 
+        u32 ir_node = u32(scene.nodes.size());
+        scene.nodes.push_back(scene_ir::Node {
+            .parent = parent_node,
+            .transform = Mat4x3(transform),
+        });
+
         transform = parent_transform * transform;
 
         if (node.meshIndex.has_value()) {
             auto[mesh_idx, mesh_count] = gltf_mesh_offsets[node.meshIndex.value()];
-            for (u32 i = 0; i < mesh_count; ++i) {
+            if (mesh_count) {
                 scene.instances.emplace_back(scene_ir::Instance {
-                    .mesh_idx = mesh_idx + i,
-                    .transform = transform,
+                    .mesh_idx = mesh_idx,
+                    .mesh_count = mesh_count,
+                    .transform = Mat4x3(transform),
+                    .node_idx = ir_node,
                 });
             }
         }
 
         for (auto child_idx : node.children) {
-            ProcessNode(child_idx, transform);
+            ProcessNode(child_idx, transform, ir_node);
         }
     }
 }
\ No newline at end of file
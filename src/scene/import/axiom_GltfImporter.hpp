@@ -20,7 +20,7 @@ namespace axiom
         void ProcessTexture(u32 tex_idx);
         void ProcessMaterial(u32 mat_idx);
         void ProcessMesh(u32 gltf_mesh_idx, u32 prim_idx);
-        void ProcessNode(usz node_idx, Mat4 parent_transform);
+        void ProcessNode(usz node_idx, Mat4 parent_transform, u32 parent_node);
 
         scene_ir::Scene Import(const std::filesystem::path& path);
     };
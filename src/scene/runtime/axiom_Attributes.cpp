@@ -297,7 +297,13 @@ namespace axiom
 
         if (!embedded_size) {
             cached_name = base64_encode(std::string_view(path), true);
-            cached_name += std::format("${}${}${}", u32(processes), max_dim, u32(UseBC7));
+            cached_name += std::format("${}${}${}${}", u32(type), u32(processes), max_dim, u32(UseBC7));
+
+            // Source size and modification time, so that edited images are reprocessed
+            std::error_code ec;
+            auto file_size = std::filesystem::file_size(path, ec);
+            auto write_time = std::filesystem::last_write_time(path, ec);
+            cached_name += std::format("${}${}", file_size, write_time.time_since_epoch().count());
             cached_path = std::filesystem::path("cache") / cached_name;
         }
 
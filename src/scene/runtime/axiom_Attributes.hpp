@@ -84,6 +84,12 @@ namespace axiom
         u32 packed;
     };
 
+    struct GPU_QuantisedPosition
+    {
+        // Fixed point position within the owning sub mesh's bounding box
+        u16 x, y, z;
+    };
+
     struct GPU_BoneWeights
     {
         u32 bone_indices[2];
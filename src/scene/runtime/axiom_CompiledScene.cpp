@@ -1,11 +1,218 @@
 #include "axiom_CompiledScene.hpp"
 
+#include <immintrin.h>
+
 namespace axiom
 {
+    void ComputeBounds(TriMesh& mesh)
+    {
+        mesh.bounds_min = Vec3(FLT_MAX);
+        mesh.bounds_max = Vec3(-FLT_MAX);
+
+        for (auto& sub_mesh : mesh.sub_meshes) {
+            u32 vertex_count = sub_mesh.max_vertex + 1;
+
+            if (mesh.IsQuantised()) {
+                sub_mesh.bounds_min = Vec3(FLT_MAX);
+                sub_mesh.bounds_max = Vec3(-FLT_MAX);
+                for (u32 i = 0; i < vertex_count; ++i) {
+                    Vec3 position = mesh.GetPosition(sub_mesh, i);
+                    sub_mesh.bounds_min = glm::min(sub_mesh.bounds_min, position);
+                    sub_mesh.bounds_max = glm::max(sub_mesh.bounds_max, position);
+                }
+            } else {
+                const f32* positions = &mesh.GetData().position_attributes[sub_mesh.vertex_offset].x;
+
+                // Unaligned 4-wide loads pick up the next vertex's x in the last lane,
+                // which is ignored. The final vertex is loaded separately to avoid
+                // reading past the end of the buffer
+
+                __m128 min = _mm_set1_ps(FLT_MAX);
+                __m128 max = _mm_set1_ps(-FLT_MAX);
+                for (u32 i = 0; i < vertex_count - 1; ++i) {
+                    __m128 v = _mm_loadu_ps(positions + i * 3);
+                    min = _mm_min_ps(min, v);
+                    max = _mm_max_ps(max, v);
+                }
+                {
+                    const f32* last = positions + (vertex_count - 1) * 3;
+                    __m128 v = _mm_setr_ps(last[0], last[1], last[2], 0.f);
+                    min = _mm_min_ps(min, v);
+                    max = _mm_max_ps(max, v);
+                }
+
+                alignas(16) f32 out_min[4];
+                alignas(16) f32 out_max[4];
+                _mm_store_ps(out_min, min);
+                _mm_store_ps(out_max, max);
+                sub_mesh.bounds_min = Vec3(out_min[0], out_min[1], out_min[2]);
+                sub_mesh.bounds_max = Vec3(out_max[0], out_max[1], out_max[2]);
+            }
+
+            sub_mesh.bounding_center = 0.5f * (sub_mesh.bounds_min + sub_mesh.bounds_max);
+            sub_mesh.bounding_radius = 0.f;
+            for (u32 i = 0; i < vertex_count; ++i) {
+                sub_mesh.bounding_radius = std::max(sub_mesh.bounding_radius,
+                    glm::distance(sub_mesh.bounding_center, mesh.GetPosition(sub_mesh, i)));
+            }
+
+            mesh.bounds_min = glm::min(mesh.bounds_min, sub_mesh.bounds_min);
+            mesh.bounds_max = glm::max(mesh.bounds_max, sub_mesh.bounds_max);
+        }
+    }
+
+    PackedTRS PackTRS(const Mat4x3& transform)
+    {
+        PackedTRS trs = {};
+
+        trs.translation = transform[3];
+        trs.scale = Vec3(glm::length(transform[0]), glm::length(transform[1]), glm::length(transform[2]));
+
+        // Mirroring is carried by a negative X scale
+
+        if (glm::determinant(Mat3(Mat4(transform))) < 0.f) {
+            trs.scale.x = -trs.scale.x;
+        }
+
+        Mat3 rotation;
+        for (u32 i = 0; i < 3; ++i) {
+            rotation[i] = trs.scale[i] != 0.f ? transform[i] / trs.scale[i] : Vec3(0.f);
+        }
+
+        Quat q = glm::normalize(glm::quat_cast(rotation));
+        std::array<f32, 4> components { q.x, q.y, q.z, q.w };
+
+        u32 largest = 0;
+        for (u32 i = 1; i < 4; ++i) {
+            if (std::abs(components[i]) > std::abs(components[largest])) {
+                largest = i;
+            }
+        }
+
+        // q and -q are the same rotation, flip so that the omitted component is positive
+
+        f32 sign = components[largest] < 0.f ? -1.f : 1.f;
+
+        trs.rotation_index = u16(largest);
+        for (u32 i = 0, j = 0; i < 4; ++i) {
+            if (i == largest) {
+                continue;
+            }
+
+            // Remaining components lie in [-1/sqrt(2), 1/sqrt(2)]
+            f32 value = sign * components[i] * std::sqrt(2.f);
+            trs.rotation[j++] = u16(std::round(std::clamp(value * 0.5f + 0.5f, 0.f, 1.f) * 65535.f));
+        }
+
+        return trs;
+    }
+
+    Mat4x3 UnpackTRS(const PackedTRS& trs)
+    {
+        std::array<f32, 4> components;
+        f32 sum = 0.f;
+        for (u32 i = 0, j = 0; i < 4; ++i) {
+            if (i == trs.rotation_index) {
+                continue;
+            }
+
+            components[i] = (f32(trs.rotation[j++]) / 65535.f * 2.f - 1.f) / std::sqrt(2.f);
+            sum += components[i] * components[i];
+        }
+        components[trs.rotation_index] = std::sqrt(std::max(0.f, 1.f - sum));
+
+        Mat3 rotation = glm::mat3_cast(Quat(components[3], components[0], components[1], components[2]));
+
+        Mat4x3 transform;
+        for (u32 i = 0; i < 3; ++i) {
+            transform[i] = rotation[i] * trs.scale[i];
+        }
+        transform[3] = trs.translation;
+
+        return transform;
+    }
+
+    void ComputeWorldBounds(const TriMesh& mesh, TriMeshInstance& instance)
+    {
+        // https://github.com/erich666/GraphicsGems/blob/master/gems/TransBox.c
+
+        auto& transform = instance.transform;
+
+        Vec3 center = 0.5f * (mesh.bounds_min + mesh.bounds_max);
+        Vec3 extent = 0.5f * (mesh.bounds_max - mesh.bounds_min);
+
+        Vec3 world_center = transform * Vec4(center, 1.f);
+        Vec3 world_extent = glm::abs(Vec3(transform[0])) * extent.x
+            + glm::abs(Vec3(transform[1])) * extent.y
+            + glm::abs(Vec3(transform[2])) * extent.z;
+
+        instance.world_min = world_center - world_extent;
+        instance.world_max = world_center + world_extent;
+    }
+
+    u32 SelectLod(const TriMesh& mesh, const TriMeshInstance& instance, const LodView& view)
+    {
+        auto& transform = instance.transform;
+        f32 scale = std::max({
+            glm::length(Vec3(transform[0])),
+            glm::length(Vec3(transform[1])),
+            glm::length(Vec3(transform[2])),
+        });
+
+        // Pixels per unit of world space error at unit distance
+        f32 projection = view.viewport_height / (2.f * glm::tan(0.5f * view.fov));
+
+        u32 level = 0;
+        for (auto& sub_mesh : mesh.sub_meshes) {
+            level = std::max(level, u32(sub_mesh.lods.size()));
+        }
+
+        for (auto& sub_mesh : mesh.sub_meshes) {
+            if (sub_mesh.lods.empty()) {
+                continue;
+            }
+
+            Vec3 center = Vec3(transform * Vec4(sub_mesh.bounding_center, 1.f));
+            f32 distance = glm::distance(center, view.position) - sub_mesh.bounding_radius * scale;
+            distance = std::max(distance, 1e-4f);
+
+            u32 sub_mesh_level = 0;
+            for (u32 i = u32(sub_mesh.lods.size()); i > 0; --i) {
+                f32 pixel_error = sub_mesh.lods[i - 1].error * scale / distance * projection;
+                if (pixel_error <= view.max_pixel_error) {
+                    sub_mesh_level = i;
+                    break;
+                }
+            }
+
+            if (sub_mesh_level < sub_mesh.lods.size()) {
+                level = std::min(level, sub_mesh_level);
+            }
+        }
+
+        return level;
+    }
+
+    void CompiledScene::UpdateTransforms()
+    {
+        transforms.Update();
+
+#pragma omp parallel for
+        for (u32 i = 0; i < instances.size(); ++i) {
+            auto& instance = instances[i];
+            if (instance.node == TransformHierarchy::InvalidNode || !transforms.IsUpdated(instance.node)) {
+                continue;
+            }
+
+            instance.transform = transforms.GetWorld(instance.node);
+            ComputeWorldBounds(Get(instance.mesh), instance);
+        }
+    }
+
     void CompiledScene::Compile(imp::Scene& scene)
     {
-        auto default_material = Ref<UVMaterial>::Create();
-        materials.push_back(default_material);
+        Index<UVMaterial> default_material = materials.size();
+        materials.emplace_back();
 
         nova::HashMap<u32, u32> single_pixel_textures;
 
@@ -20,24 +227,24 @@ namespace axiom
             u32 encoded = std::bit_cast<u32>(data);
 
             if (single_pixel_textures.contains(encoded)) {
-                return textures[single_pixel_textures.at(encoded)];
+                return Index<UVTexture>(single_pixel_textures.at(encoded));
             }
 
-            auto image = Ref<UVTexture>::Create();
-            image->size = Vec2(1);
-            image->data = { b8(data[0]), b8(data[1]), b8(data[2]), b8(data[3]) };
+            Index<UVTexture> image = textures.size();
+            auto& texture = textures.emplace_back();
+            texture.size = Vec2(1);
+            texture.data = { b8(data[0]), b8(data[1]), b8(data[2]), b8(data[3]) };
 
-            textures.push_back(image);
-            single_pixel_textures.insert({ encoded, u32(textures.size() - 1) });
+            single_pixel_textures.insert({ encoded, image.value });
 
             return image;
         };
 
-        default_material->basecolor_alpha = CreatePixelImage({ 1.f, 0.f, 1.f, 1.f });
-        default_material->normals = CreatePixelImage({ 0.5f, 0.5f, 1.f, 1.f });
-        default_material->metalness_roughness = CreatePixelImage({ 0.f, 0.5f, 0.f, 1.f });
-        default_material->emissivity = CreatePixelImage({ 0.f, 0.f, 0.f, 1.f });
-        default_material->transmission = CreatePixelImage({ 0.f, 0.f, 0.f, 255.f });
+        Get(default_material).basecolor_alpha = CreatePixelImage({ 1.f, 0.f, 1.f, 1.f });
+        Get(default_material).normals = CreatePixelImage({ 0.5f, 0.5f, 1.f, 1.f });
+        Get(default_material).metalness_roughness = CreatePixelImage({ 0.f, 0.5f, 0.f, 1.f });
+        Get(default_material).emissivity = CreatePixelImage({ 0.f, 0.f, 0.f, 1.f });
+        Get(default_material).transmission = CreatePixelImage({ 0.f, 0.f, 0.f, 255.f });
 
         for (u32 i = 0; i < scene.geometry_ranges.count; ++i) {
             auto& range = scene.geometry_ranges[i];
@@ -46,43 +253,43 @@ namespace axiom
             u32 index_count = range.triangle_count * 3;
             u32 vertex_count = range.max_vertex + 1;
 
-            auto out_mesh = Ref<TriMesh>::Create();
-            meshes.emplace_back(out_mesh);
+            auto& out_mesh = meshes.emplace_back();
 
-            out_mesh->indices.resize(index_count);
-            out_mesh->position_attributes.resize(vertex_count);
-            out_mesh->shading_attributes.resize(vertex_count);
+            out_mesh.indices.resize(index_count);
+            out_mesh.position_attributes.resize(vertex_count);
+            out_mesh.shading_attributes.resize(vertex_count);
 
             geometry.indices
                 .Slice(range.first_index, index_count)
-                .CopyTo({ out_mesh->indices.data(), index_count });
+                .CopyTo({ out_mesh.indices.data(), index_count });
 
             geometry.positions
                 .Slice(range.vertex_offset, vertex_count)
-                .CopyTo({ out_mesh->position_attributes.data(), vertex_count });
+                .CopyTo({ out_mesh.position_attributes.data(), vertex_count });
 
             for (u32 i = 0; i < vertex_count; ++i) {
-                out_mesh->shading_attributes[i].tangent_space = std::bit_cast<GPU_TangentSpace>(geometry.tangent_spaces[i]);
-                out_mesh->shading_attributes[i].tex_coords = std::bit_cast<GPU_TexCoords>(geometry.tex_coords[i]);
+                out_mesh.shading_attributes[i].tangent_space = std::bit_cast<GPU_TangentSpace>(geometry.tangent_spaces[i]);
+                out_mesh.shading_attributes[i].tex_coords = std::bit_cast<GPU_TexCoords>(geometry.tex_coords[i]);
             }
 
-            out_mesh->sub_meshes.emplace_back(TriSubMesh {
+            out_mesh.sub_meshes.emplace_back(TriSubMesh {
                 .vertex_offset = 0,
                 .max_vertex = vertex_count - 1,
                 .first_index = 0,
                 .index_count = index_count,
                 .material = default_material,
             });
+
+            ComputeBounds(out_mesh);
         }
 
         for (u32 i = 0; i < scene.meshes.count; ++i) {
             auto& mesh = scene.meshes[i];
 
-            auto instance = Ref<TriMeshInstance>::Create();
-            instances.emplace_back(instance);
-
-            instance->mesh = meshes[mesh.geometry_range_idx];
-            instance->transform = Mat4(mesh.transform);
+            auto& instance = instances.emplace_back();
+            instance.mesh = mesh.geometry_range_idx;
+            instance.transform = mesh.transform;
+            ComputeWorldBounds(Get(instance.mesh), instance);
         }
     }
 }
\ No newline at end of file
@@ -3,12 +3,35 @@
 #include "axiom_Core.hpp"
 
 #include "axiom_Attributes.hpp"
+#include "axiom_TransformHierarchy.hpp"
 
 #include <imp/imp_Importer.hpp>
 
+struct scene_t;
+
 namespace axiom
 {
-    struct UVTexture : nova::RefCounted
+    // Typed index into one of the CompiledScene arrays
+    template<class T>
+    struct Index
+    {
+        u32 value = UINT32_MAX;
+
+        Index() = default;
+
+        Index(usz i) noexcept
+            : value(u32(i))
+        {}
+
+        bool IsValid() const noexcept
+        {
+            return value != UINT32_MAX;
+        }
+
+        bool operator==(const Index&) const noexcept = default;
+    };
+
+    struct UVTexture
     {
         Vec2U           size;
         std::vector<b8> data;
@@ -17,15 +40,23 @@ namespace axiom
 
         f32 min_alpha = 1.f;
         f32 max_alpha = 0.f;
+
+        // When set, data is read from memory owned elsewhere instead, see GetData
+        std::optional<std::span<const b8>> mapped;
+
+        std::span<const b8> GetData() const
+        {
+            return mapped ? *mapped : std::span<const b8>(data);
+        }
     };
 
-    struct UVMaterial : nova::RefCounted
+    struct UVMaterial
     {
-        nova::Ref<UVTexture>     basecolor_alpha;
-        nova::Ref<UVTexture>             normals;
-        nova::Ref<UVTexture>          emissivity;
-        nova::Ref<UVTexture>        transmission;
-        nova::Ref<UVTexture> metalness_roughness;
+        Index<UVTexture>     basecolor_alpha;
+        Index<UVTexture>             normals;
+        Index<UVTexture>          emissivity;
+        Index<UVTexture>        transmission;
+        Index<UVTexture> metalness_roughness;
 
         f32  alpha_cutoff = 0.5f;
         bool   alpha_mask = false;
@@ -35,13 +66,38 @@ namespace axiom
         bool        decal = false;
     };
 
+    struct TriSubMeshLod
+    {
+        u32 first_index;
+        u32 index_count;
+        f32       error;
+    };
+
     struct TriSubMesh
     {
         u32              vertex_offset;
         u32                 max_vertex;
         u32                first_index;
         u32                index_count;
-        nova::Ref<UVMaterial> material;
+        Index<UVMaterial>      material;
+
+        // Selects whether first_index (and all LOD ranges) index into the
+        // owning mesh's indices or indices_u16
+        nova::IndexType index_type = nova::IndexType::U32;
+
+        // Object space bounds, see ComputeBounds
+        Vec3      bounds_min = {};
+        Vec3      bounds_max = {};
+        Vec3 bounding_center = {};
+        f32  bounding_radius = 0.f;
+
+        // Maps quantised positions back to object space
+        Vec3 dequant_offset = Vec3(0.f);
+        Vec3  dequant_scale = Vec3(1.f);
+
+        // Progressively simplified index ranges into the owning mesh, sharing the
+        // same vertices. Errors are in object space and increase with each level
+        std::vector<TriSubMeshLod> lods;
     };
 
     struct ShadingAttributes
@@ -50,47 +106,212 @@ namespace axiom
         GPU_TexCoords       tex_coords;
     };
 
-    struct TriMesh : nova::RefCounted
+    // Read only view of mesh geometry
+    struct TriMeshData
+    {
+        std::span<const Vec3>                  position_attributes;
+        std::span<const ShadingAttributes>      shading_attributes;
+        std::span<const u32>                               indices;
+        std::span<const u16>                           indices_u16;
+        std::span<const GPU_QuantisedPosition> quantised_positions;
+    };
+
+    struct TriMesh
     {
         std::vector<Vec3>             position_attributes;
         std::vector<ShadingAttributes> shading_attributes;
         std::vector<u32>                          indices;
+        std::vector<u16>                      indices_u16;
+
+        // When present replaces position_attributes, decoded per sub mesh
+        // with the sub mesh dequantisation scale and offset
+        std::vector<GPU_QuantisedPosition> quantised_positions;
+        f32                               quantisation_error = 0.f;
 
         std::vector<TriSubMesh> sub_meshes;
+
+        // Union of all sub mesh bounds
+        Vec3 bounds_min = {};
+        Vec3 bounds_max = {};
+
+        // When set, geometry is read from memory owned elsewhere instead of the vectors
+        // above, such as a MappedSceneFile. Consumers should read through GetData
+        std::optional<TriMeshData> mapped;
+
+        TriMeshData GetData() const
+        {
+            if (mapped) {
+                return *mapped;
+            }
+
+            return { position_attributes, shading_attributes, indices, indices_u16, quantised_positions };
+        }
+
+        u32 GetIndex(nova::IndexType type, u32 i) const
+        {
+            if (mapped) {
+                return type == nova::IndexType::U16
+                    ? u32(mapped->indices_u16[i])
+                    : mapped->indices[i];
+            }
+
+            return type == nova::IndexType::U16
+                ? u32(indices_u16[i])
+                : indices[i];
+        }
+
+        usz GetVertexCount() const
+        {
+            return mapped ? mapped->shading_attributes.size() : shading_attributes.size();
+        }
+
+        bool IsQuantised() const
+        {
+            return mapped ? !mapped->quantised_positions.empty() : !quantised_positions.empty();
+        }
+
+        Vec3 GetPosition(const TriSubMesh& sub_mesh, u32 i) const
+        {
+            if (!IsQuantised()) {
+                return mapped
+                    ? mapped->position_attributes[sub_mesh.vertex_offset + i]
+                    : position_attributes[sub_mesh.vertex_offset + i];
+            }
+
+            auto q = mapped
+                ? mapped->quantised_positions[sub_mesh.vertex_offset + i]
+                : quantised_positions[sub_mesh.vertex_offset + i];
+            return sub_mesh.dequant_offset + sub_mesh.dequant_scale * Vec3(f32(q.x), f32(q.y), f32(q.z));
+        }
+
+        // Writes object space positions for every vertex regardless of storage format
+        void DecodePositions(std::vector<Vec3>& positions) const
+        {
+            auto data = GetData();
+            if (!IsQuantised()) {
+                positions.assign(data.position_attributes.begin(), data.position_attributes.end());
+                return;
+            }
+
+            positions.resize(data.quantised_positions.size());
+            for (auto& sub_mesh : sub_meshes) {
+                for (u32 i = 0; i <= sub_mesh.max_vertex; ++i) {
+                    positions[sub_mesh.vertex_offset + i] = GetPosition(sub_mesh, i);
+                }
+            }
+        }
     };
 
-    struct TriMeshInstance : nova::RefCounted
+    struct TriMeshInstance
     {
-        nova::Ref<TriMesh> mesh;
-        nova::Mat4    transform;
+        Index<TriMesh>    mesh;
+        Mat4x3       transform;
+
+        // Node driving transform, static if invalid. See CompiledScene::UpdateTransforms
+        u32 node = TransformHierarchy::InvalidNode;
+
+        // World space bounds, see ComputeWorldBounds
+        Vec3 world_min = {};
+        Vec3 world_max = {};
     };
 
+    // Quantised translation, rotation and scale of an instance transform, for
+    // streaming. Rotations store the three smallest quaternion components, the
+    // omitted component is recovered from unit length. Transforms with shear are
+    // not representable, see UnpackTRS
+    struct PackedTRS
+    {
+        Vec3    translation;
+        Vec3          scale;
+        u16     rotation[3];
+        u16  rotation_index;
+    };
+
+    PackedTRS PackTRS(const Mat4x3& transform);
+    Mat4x3 UnpackTRS(const PackedTRS& trs);
+
+    // Computes axis aligned bounds and bounding spheres for every sub mesh,
+    // and the combined mesh bounds
+    void ComputeBounds(TriMesh& mesh);
+
+    // Transforms the bounds of the instanced mesh into world space
+    void ComputeWorldBounds(const TriMesh& mesh, TriMeshInstance& instance);
+
+    // Object space transform applied to quantised positions of a sub mesh, to be
+    // folded into the instance transform by renderers
+    inline
+    Mat4 GetDequantisationTransform(const TriMesh& mesh, const TriSubMesh& sub_mesh)
+    {
+        if (!mesh.IsQuantised()) {
+            return Mat4(1.f);
+        }
+
+        return glm::scale(glm::translate(Mat4(1.f), sub_mesh.dequant_offset), sub_mesh.dequant_scale);
+    }
+
+    struct LodView
+    {
+        Vec3        position;
+        f32              fov;
+        f32  viewport_height;
+        f32  max_pixel_error = 1.f;
+    };
+
+    // Returns the coarsest level of detail for which every sub mesh of the instance
+    // stays within view.max_pixel_error when projected. Level 0 is the full resolution
+    // mesh, level N selects sub_mesh.lods[min(N, lods.size()) - 1]
+    u32 SelectLod(const TriMesh& mesh, const TriMeshInstance& instance, const LodView& view);
+
+    // Flat scene storage, all objects are referenced by their index in these arrays
     struct CompiledScene
     {
-        std::vector<nova::Ref<UVTexture>>        textures;
-        std::vector<nova::Ref<UVMaterial>>      materials;
-        std::vector<nova::Ref<TriMesh>>            meshes;
-        std::vector<nova::Ref<TriMeshInstance>> instances;
+        std::vector<UVTexture>        textures;
+        std::vector<UVMaterial>      materials;
+        std::vector<TriMesh>            meshes;
+        std::vector<TriMeshInstance> instances;
+
+        TransformHierarchy transforms;
+
+        UVTexture&        Get(Index<UVTexture>  i)       { return  textures[i.value]; }
+        const UVTexture&  Get(Index<UVTexture>  i) const { return  textures[i.value]; }
+        UVMaterial&       Get(Index<UVMaterial> i)       { return materials[i.value]; }
+        const UVMaterial& Get(Index<UVMaterial> i) const { return materials[i.value]; }
+        TriMesh&          Get(Index<TriMesh>    i)       { return    meshes[i.value]; }
+        const TriMesh&    Get(Index<TriMesh>    i) const { return    meshes[i.value]; }
 
         inline
         void DebugDump()
         {
             for (auto[mesh_idx, mesh] : meshes | std::views::enumerate) {
                 NOVA_LOG("Mesh[{}]", mesh_idx);
-                NOVA_LOGEXPR(mesh->indices.size());
-                NOVA_LOGEXPR(mesh->shading_attributes.size());
-                NOVA_LOGEXPR(mesh->position_attributes.size());
-                NOVA_LOGEXPR(mesh->sub_meshes.size());
-                for (auto[sub_mesh_idx, sub_mesh] : mesh->sub_meshes | std::views::enumerate) {
+                NOVA_LOGEXPR(mesh.GetData().indices.size());
+                NOVA_LOGEXPR(mesh.GetData().indices_u16.size());
+                NOVA_LOGEXPR(mesh.GetData().shading_attributes.size());
+                NOVA_LOGEXPR(mesh.GetData().position_attributes.size());
+                NOVA_LOGEXPR(mesh.GetData().quantised_positions.size());
+                NOVA_LOGEXPR(mesh.sub_meshes.size());
+                for (auto[sub_mesh_idx, sub_mesh] : mesh.sub_meshes | std::views::enumerate) {
                     NOVA_LOG("Submesh[{}]", sub_mesh_idx);
                     NOVA_LOGEXPR(sub_mesh.vertex_offset);
                     NOVA_LOGEXPR(sub_mesh.max_vertex);
                     NOVA_LOGEXPR(sub_mesh.first_index);
                     NOVA_LOGEXPR(sub_mesh.index_count);
+                    NOVA_LOGEXPR(sub_mesh.material.value);
+                    NOVA_LOGEXPR(u32(sub_mesh.index_type == nova::IndexType::U16));
+                    NOVA_LOGEXPR(sub_mesh.lods.size());
                 }
             }
         }
 
         void Compile(imp::Scene& scene);
+
+        // Propagates node changes made through transforms.SetLocal, and refreshes the
+        // transforms and world bounds of affected instances
+        void UpdateTransforms();
+
+        // Appends the contents of a scene file, throwing if it is malformed. Geometry
+        // and textures are referenced in place, see MappedSceneFile. Nodes are appended
+        // to transforms, and UpdateTransforms is called to resolve them
+        void Load(const scene_t& scene);
     };
 }
\ No newline at end of file
@@ -0,0 +1,289 @@
+#include "axiom_DynamicScene.hpp"
+
+namespace axiom
+{
+    namespace
+    {
+        // Marks journal entries cancelled by a later change to the same object
+        constexpr u32 CancelledChange = UINT32_MAX;
+
+        constexpr const char* ObjectTypeNames[] { "Texture", "Material", "Mesh", "Instance" };
+    }
+
+    template<class T>
+    Handle<T> DynamicScene::Insert(Pool<T>& pool, ObjectType object, T&& value)
+    {
+        u32 index;
+        if (pool.free_list.empty()) {
+            index = u32(pool.objects.size());
+            pool.objects.emplace_back();
+            pool.generations.push_back(0);
+            pool.ref_counts.push_back(0);
+            pool.journal_entries.push_back(UINT32_MAX);
+        } else {
+            index = pool.free_list.back();
+            pool.free_list.pop_back();
+        }
+
+        // Generations are odd while a slot is alive
+
+        pool.objects[index] = std::move(value);
+        pool.generations[index]++;
+
+        Record(pool, object, ChangeType::Added, index);
+
+        return { index, pool.generations[index] };
+    }
+
+    template<class T>
+    T DynamicScene::Erase(Pool<T>& pool, ObjectType object, Handle<T> handle)
+    {
+        Validate(pool, handle);
+
+        if (pool.ref_counts[handle.index]) {
+            NOVA_THROW("{}[{}] removed while still referenced {} times",
+                ObjectTypeNames[u32(object)], handle.index, pool.ref_counts[handle.index]);
+        }
+
+        T removed = std::move(pool.objects[handle.index]);
+        pool.objects[handle.index] = {};
+        pool.generations[handle.index]++;
+        pool.free_list.push_back(handle.index);
+
+        Record(pool, object, ChangeType::Removed, handle.index);
+
+        return removed;
+    }
+
+    template<class T>
+    void DynamicScene::Record(Pool<T>& pool, ObjectType object, ChangeType type, u32 index)
+    {
+        u32& entry = pool.journal_entries[index];
+
+        if (entry != UINT32_MAX) {
+            auto& last = journal[entry];
+            if (type == ChangeType::Updated && last.type != ChangeType::Removed) {
+                // Already pending as added or updated
+                return;
+            }
+
+            if (type == ChangeType::Removed) {
+                bool added = last.type == ChangeType::Added;
+                last.index = CancelledChange;
+                entry = UINT32_MAX;
+                if (added) {
+                    return;
+                }
+            }
+        }
+
+        entry = u32(journal.size());
+        journal.push_back({ object, type, index });
+    }
+
+    template<class T>
+    void DynamicScene::Validate(const Pool<T>& pool, Handle<T> handle) const
+    {
+        if (!pool.IsAlive(handle.index) || pool.generations[handle.index] != handle.generation) {
+            NOVA_THROW("Stale or invalid handle [{}, generation {}]", handle.index, handle.generation);
+        }
+    }
+
+    template<class T>
+    void DynamicScene::ValidateReference(const Pool<T>& pool, Index<T> index) const
+    {
+        if (index.IsValid() && !pool.IsAlive(index.value)) {
+            NOVA_THROW("Reference to missing object [{}]", index.value);
+        }
+    }
+
+    template<class T>
+    void DynamicScene::Acquire(Pool<T>& pool, Index<T> index)
+    {
+        if (index.IsValid()) {
+            pool.ref_counts[index.value]++;
+        }
+    }
+
+    template<class T>
+    void DynamicScene::Release(Pool<T>& pool, Index<T> index)
+    {
+        if (index.IsValid()) {
+            pool.ref_counts[index.value]--;
+        }
+    }
+
+// -----------------------------------------------------------------------------
+
+    Handle<UVTexture> DynamicScene::AddTexture(UVTexture texture)
+    {
+        return Insert(textures, ObjectType::Texture, std::move(texture));
+    }
+
+    // References are all validated before any are acquired, so that a throw leaves reference counts unchanged
+
+    Handle<UVMaterial> DynamicScene::AddMaterial(UVMaterial material)
+    {
+        std::array references {
+            material.basecolor_alpha,
+            material.normals,
+            material.emissivity,
+            material.transmission,
+            material.metalness_roughness,
+        };
+
+        for (auto texture : references) {
+            ValidateReference(textures, texture);
+        }
+
+        for (auto texture : references) {
+            Acquire(textures, texture);
+        }
+
+        return Insert(materials, ObjectType::Material, std::move(material));
+    }
+
+    Handle<TriMesh> DynamicScene::AddMesh(TriMesh mesh)
+    {
+        for (auto& sub_mesh : mesh.sub_meshes) {
+            ValidateReference(materials, sub_mesh.material);
+        }
+
+        for (auto& sub_mesh : mesh.sub_meshes) {
+            Acquire(materials, sub_mesh.material);
+        }
+
+        return Insert(meshes, ObjectType::Mesh, std::move(mesh));
+    }
+
+    Handle<TriMeshInstance> DynamicScene::AddInstance(Handle<TriMesh> mesh, const Mat4x3& transform)
+    {
+        Validate(meshes, mesh);
+        Acquire(meshes, mesh.ToIndex());
+
+        TriMeshInstance instance;
+        instance.mesh = mesh.ToIndex();
+        instance.transform = transform;
+        ComputeWorldBounds(meshes.objects[mesh.index], instance);
+
+        return Insert(instances, ObjectType::Instance, std::move(instance));
+    }
+
+    void DynamicScene::Remove(Handle<UVTexture> texture)
+    {
+        Erase(textures, ObjectType::Texture, texture);
+    }
+
+    void DynamicScene::Remove(Handle<UVMaterial> material)
+    {
+        auto removed = Erase(materials, ObjectType::Material, material);
+        Release(textures, removed.basecolor_alpha);
+        Release(textures, removed.normals);
+        Release(textures, removed.emissivity);
+        Release(textures, removed.transmission);
+        Release(textures, removed.metalness_roughness);
+    }
+
+    void DynamicScene::Remove(Handle<TriMesh> mesh)
+    {
+        auto removed = Erase(meshes, ObjectType::Mesh, mesh);
+        for (auto& sub_mesh : removed.sub_meshes) {
+            Release(materials, sub_mesh.material);
+        }
+    }
+
+    void DynamicScene::Remove(Handle<TriMeshInstance> instance)
+    {
+        auto removed = Erase(instances, ObjectType::Instance, instance);
+        Release(meshes, removed.mesh);
+    }
+
+    void DynamicScene::SetTransform(Handle<TriMeshInstance> handle, const Mat4x3& transform)
+    {
+        Validate(instances, handle);
+
+        auto& instance = instances.objects[handle.index];
+        instance.transform = transform;
+        ComputeWorldBounds(meshes.objects[instance.mesh.value], instance);
+
+        Record(instances, ObjectType::Instance, ChangeType::Updated, handle.index);
+    }
+
+    std::vector<Handle<TriMeshInstance>> DynamicScene::Add(CompiledScene&& scene)
+    {
+        // Instances are moved through SetTransform instead of a hierarchy, as nodes cannot be
+        // removed from a TransformHierarchy and would outlive the instances they drive. Pending
+        // node changes are resolved first so that each instance keeps its current world transform
+
+        scene.UpdateTransforms();
+
+        std::vector<Handle<UVTexture>> texture_handles(scene.textures.size());
+        for (u32 i = 0; i < scene.textures.size(); ++i) {
+            texture_handles[i] = AddTexture(std::move(scene.textures[i]));
+        }
+
+        auto RemapTexture = [&](Index<UVTexture>& index) {
+            if (index.IsValid()) {
+                index = texture_handles[index.value].ToIndex();
+            }
+        };
+
+        std::vector<Handle<UVMaterial>> material_handles(scene.materials.size());
+        for (u32 i = 0; i < scene.materials.size(); ++i) {
+            auto& material = scene.materials[i];
+            RemapTexture(material.basecolor_alpha);
+            RemapTexture(material.normals);
+            RemapTexture(material.emissivity);
+            RemapTexture(material.transmission);
+            RemapTexture(material.metalness_roughness);
+            material_handles[i] = AddMaterial(std::move(material));
+        }
+
+        std::vector<Handle<TriMesh>> mesh_handles(scene.meshes.size());
+        for (u32 i = 0; i < scene.meshes.size(); ++i) {
+            auto& mesh = scene.meshes[i];
+            for (auto& sub_mesh : mesh.sub_meshes) {
+                if (sub_mesh.material.IsValid()) {
+                    sub_mesh.material = material_handles[sub_mesh.material.value].ToIndex();
+                }
+            }
+            mesh_handles[i] = AddMesh(std::move(mesh));
+        }
+
+        std::vector<Handle<TriMeshInstance>> instance_handles(scene.instances.size());
+        for (u32 i = 0; i < scene.instances.size(); ++i) {
+            auto& instance = scene.instances[i];
+            instance_handles[i] = AddInstance(mesh_handles[instance.mesh.value], instance.transform);
+        }
+
+        scene = {};
+
+        return instance_handles;
+    }
+
+    void DynamicScene::ConsumeChanges(std::vector<SceneChange>& changes)
+    {
+        changes.clear();
+
+        auto Reset = [](auto& pool, u32 index) {
+            pool.journal_entries[index] = UINT32_MAX;
+        };
+
+        for (auto& change : journal) {
+            if (change.index == CancelledChange) {
+                continue;
+            }
+
+            switch (change.object) {
+                break;case ObjectType::Texture:  Reset( textures, change.index);
+                break;case ObjectType::Material: Reset(materials, change.index);
+                break;case ObjectType::Mesh:     Reset(   meshes, change.index);
+                break;case ObjectType::Instance: Reset(instances, change.index);
+            }
+
+            changes.push_back(change);
+        }
+
+        journal.clear();
+    }
+}
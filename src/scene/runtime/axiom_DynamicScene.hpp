@@ -0,0 +1,142 @@
+#pragma once
+
+#include "axiom_CompiledScene.hpp"
+
+namespace axiom
+{
+    // Stable reference to an object in a DynamicScene. The index is the object's slot,
+    // which matches the Index<T> used by other objects to reference it. Slots are
+    // reused after removal, the generation distinguishes stale handles
+    template<class T>
+    struct Handle
+    {
+        u32      index = UINT32_MAX;
+        u32 generation = 0;
+
+        bool IsValid() const noexcept
+        {
+            return index != UINT32_MAX;
+        }
+
+        Index<T> ToIndex() const noexcept
+        {
+            return index;
+        }
+
+        bool operator==(const Handle&) const noexcept = default;
+    };
+
+    enum class ObjectType : u8
+    {
+        Texture,
+        Material,
+        Mesh,
+        Instance,
+    };
+
+    enum class ChangeType : u8
+    {
+        Added,
+        Updated,
+        Removed,
+    };
+
+    struct SceneChange
+    {
+        ObjectType object;
+        ChangeType   type;
+        u32         index;
+    };
+
+    // Scene storage that objects can be added to and removed from at any time. All
+    // changes are recorded in a journal, so that renderers can apply only the
+    // differences since they last consumed it instead of rebuilding everything
+    struct DynamicScene
+    {
+        template<class T>
+        struct Pool
+        {
+            std::vector<T>            objects;
+            std::vector<u32>      generations;
+            std::vector<u32>       ref_counts;
+            std::vector<u32>   journal_entries;
+            std::vector<u32>        free_list;
+
+            // Objects in free slots are left default constructed
+            bool IsAlive(u32 index) const noexcept
+            {
+                return index < objects.size() && (generations[index] & 1);
+            }
+        };
+
+    private:
+        Pool<UVTexture>        textures;
+        Pool<UVMaterial>      materials;
+        Pool<TriMesh>            meshes;
+        Pool<TriMeshInstance> instances;
+
+        std::vector<SceneChange> journal;
+
+        template<class T>
+        Handle<T> Insert(Pool<T>& pool, ObjectType object, T&& value);
+
+        // Returns the removed object, so that its references can be released
+        template<class T>
+        T Erase(Pool<T>& pool, ObjectType object, Handle<T> handle);
+
+        template<class T>
+        void Record(Pool<T>& pool, ObjectType object, ChangeType type, u32 index);
+
+        template<class T>
+        void Validate(const Pool<T>& pool, Handle<T> handle) const;
+
+        // Throws if a valid index does not refer to a live object
+        template<class T>
+        void ValidateReference(const Pool<T>& pool, Index<T> index) const;
+
+        template<class T>
+        void Acquire(Pool<T>& pool, Index<T> index);
+
+        template<class T>
+        void Release(Pool<T>& pool, Index<T> index);
+
+    public:
+        Handle<UVTexture>        AddTexture(UVTexture texture);
+        Handle<UVMaterial>      AddMaterial(UVMaterial material);
+        Handle<TriMesh>             AddMesh(TriMesh mesh);
+        Handle<TriMeshInstance> AddInstance(Handle<TriMesh> mesh, const Mat4x3& transform);
+
+        // Objects must not be referenced by any other live object when removed
+        void Remove(Handle<UVTexture> texture);
+        void Remove(Handle<UVMaterial> material);
+        void Remove(Handle<TriMesh> mesh);
+        void Remove(Handle<TriMeshInstance> instance);
+
+        void SetTransform(Handle<TriMeshInstance> instance, const Mat4x3& transform);
+
+        bool IsAlive(Handle<UVTexture>        h) const { return  textures.IsAlive(h.index) &&  textures.generations[h.index] == h.generation; }
+        bool IsAlive(Handle<UVMaterial>       h) const { return materials.IsAlive(h.index) && materials.generations[h.index] == h.generation; }
+        bool IsAlive(Handle<TriMesh>          h) const { return    meshes.IsAlive(h.index) &&    meshes.generations[h.index] == h.generation; }
+        bool IsAlive(Handle<TriMeshInstance>  h) const { return instances.IsAlive(h.index) && instances.generations[h.index] == h.generation; }
+
+        const UVTexture&        Get(Index<UVTexture>        i) const { return  textures.objects[i.value]; }
+        const UVMaterial&       Get(Index<UVMaterial>       i) const { return materials.objects[i.value]; }
+        const TriMesh&          Get(Index<TriMesh>          i) const { return    meshes.objects[i.value]; }
+        const TriMeshInstance&  Get(Index<TriMeshInstance>  i) const { return instances.objects[i.value]; }
+
+        // Slot arrays, for renderers sizing buffers indexed by slot
+        const Pool<UVTexture>&        GetTextures() const { return  textures; }
+        const Pool<UVMaterial>&      GetMaterials() const { return materials; }
+        const Pool<TriMesh>&            GetMeshes() const { return    meshes; }
+        const Pool<TriMeshInstance>& GetInstances() const { return instances; }
+
+        // Moves all objects of a compiled scene in, remapping indices to their new slots.
+        // Instances are detached from the scene's transform hierarchy, keeping their world
+        // transforms. Returns the handles of the added instances
+        std::vector<Handle<TriMeshInstance>> Add(CompiledScene&& scene);
+
+        // Changes since the last call, in order. Repeated changes to the same object are
+        // coalesced, and objects added and removed in between are omitted entirely
+        void ConsumeChanges(std::vector<SceneChange>& changes);
+    };
+}
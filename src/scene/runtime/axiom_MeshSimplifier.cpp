@@ -0,0 +1,300 @@
+#include "axiom_MeshSimplifier.hpp"
+
+namespace axiom
+{
+    namespace
+    {
+        struct PositionKey
+        {
+            Vec3 position;
+
+            bool operator==(const PositionKey& other) const noexcept
+            {
+                return std::memcmp(&position, &other.position, sizeof(Vec3)) == 0;
+            }
+        };
+    }
+}
+NOVA_MEMORY_HASH(axiom::PositionKey);
+namespace axiom
+{
+    namespace
+    {
+        inline
+        void AddPlane(auto& q, Vec3 normal, f32 d, f32 weight)
+        {
+            f64 a = normal.x, b = normal.y, c = normal.z;
+
+            q.a00 += weight * a * a; q.a01 += weight * a * b; q.a02 += weight * a * c; q.a03 += weight * a * d;
+            q.a11 += weight * b * b; q.a12 += weight * b * c; q.a13 += weight * b * d;
+            q.a22 += weight * c * c; q.a23 += weight * c * d;
+            q.a33 += weight * d * d;
+
+            q.weight += weight;
+        }
+
+        inline
+        void AddQuadric(auto& q, const auto& other)
+        {
+            q.a00 += other.a00; q.a01 += other.a01; q.a02 += other.a02; q.a03 += other.a03;
+            q.a11 += other.a11; q.a12 += other.a12; q.a13 += other.a13;
+            q.a22 += other.a22; q.a23 += other.a23;
+            q.a33 += other.a33;
+
+            q.weight += other.weight;
+        }
+
+        // Returns the area weighted mean squared distance of p to the planes in q + r
+        inline
+        f32 EvaluateQuadric(const auto& q, const auto& r, Vec3 p)
+        {
+            f64 x = p.x, y = p.y, z = p.z;
+
+            f64 e = (q.a00 + r.a00) * x * x + 2.0 * (q.a01 + r.a01) * x * y + 2.0 * (q.a02 + r.a02) * x * z + 2.0 * (q.a03 + r.a03) * x
+                  + (q.a11 + r.a11) * y * y + 2.0 * (q.a12 + r.a12) * y * z + 2.0 * (q.a13 + r.a13) * y
+                  + (q.a22 + r.a22) * z * z + 2.0 * (q.a23 + r.a23) * z
+                  + (q.a33 + r.a33);
+
+            f64 weight = q.weight + r.weight;
+
+            return weight > 0.0 ? f32(std::abs(e) / weight) : 0.f;
+        }
+
+        inline
+        u64 EdgeKey(u32 a, u32 b)
+        {
+            return a < b
+                ? (u64(a) << 32) | b
+                : (u64(b) << 32) | a;
+        }
+    }
+
+    f32 MeshSimplifier::Simplify(
+        nova::Span<const Vec3> positions,
+        nova::Span<const u32>    indices,
+        u32           target_index_count,
+        f32                    max_error,
+        std::vector<u32>&    out_indices)
+    {
+        u32 vertex_count = u32(positions.size());
+
+        out_indices.assign(indices.begin(), indices.end());
+
+        // Lock attribute seams (distinct vertices sharing a position)
+
+        vertex_locked.assign(vertex_count, 0);
+        {
+            nova::HashMap<PositionKey, u32> first_vertex;
+            for (u32 i = 0; i < vertex_count; ++i) {
+                auto[iter, inserted] = first_vertex.insert({ PositionKey(positions[i]), i });
+                if (!inserted) {
+                    vertex_locked[iter->second] = 1;
+                    vertex_locked[i] = 1;
+                }
+            }
+        }
+
+        // Lock open borders and non-manifold edges
+
+        {
+            nova::HashMap<u64, u32> edge_uses;
+            for (u32 i = 0; i < out_indices.size(); i += 3) {
+                for (u32 j = 0; j < 3; ++j) {
+                    edge_uses[EdgeKey(out_indices[i + j], out_indices[i + (j + 1) % 3])]++;
+                }
+            }
+            for (auto&[edge, uses] : edge_uses) {
+                if (uses != 2) {
+                    vertex_locked[u32(edge >> 32)] = 1;
+                    vertex_locked[u32(edge)] = 1;
+                }
+            }
+        }
+
+        // Accumulate area weighted plane quadrics
+
+        vertex_quadrics.assign(vertex_count, Quadric{});
+        for (u32 i = 0; i < out_indices.size(); i += 3) {
+            Vec3 p0 = positions[out_indices[i + 0]];
+            Vec3 p1 = positions[out_indices[i + 1]];
+            Vec3 p2 = positions[out_indices[i + 2]];
+
+            Vec3 cross = glm::cross(p1 - p0, p2 - p0);
+            f32 length = glm::length(cross);
+            if (length == 0.f) {
+                continue;
+            }
+
+            Vec3 normal = cross / length;
+            f32 d = -glm::dot(normal, p0);
+            f32 area = 0.5f * length;
+
+            for (u32 j = 0; j < 3; ++j) {
+                AddPlane(vertex_quadrics[out_indices[i + j]], normal, d, area);
+            }
+        }
+
+        // Collapse edges in passes of independent collapses until the target is reached
+
+        f32 result_error = 0.f;
+
+        while (out_indices.size() > target_index_count) {
+            u32 triangle_count = u32(out_indices.size() / 3);
+
+            // Build vertex -> triangle adjacency
+
+            adjacency_offsets.assign(vertex_count + 1, 0);
+            for (u32 index : out_indices) {
+                adjacency_offsets[index + 1]++;
+            }
+            for (u32 i = 0; i < vertex_count; ++i) {
+                adjacency_offsets[i + 1] += adjacency_offsets[i];
+            }
+            adjacency_triangles.resize(out_indices.size());
+            {
+                collapse_remap.assign(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+                for (u32 i = 0; i < out_indices.size(); ++i) {
+                    adjacency_triangles[collapse_remap[out_indices[i]]++] = i / 3;
+                }
+            }
+
+            // Find the cheapest valid direction for every edge
+
+            collapses.clear();
+            for (u32 i = 0; i < out_indices.size(); i += 3) {
+                for (u32 j = 0; j < 3; ++j) {
+                    u32 a = out_indices[i + j];
+                    u32 b = out_indices[i + (j + 1) % 3];
+
+                    // Interior edges are seen once in each direction, only consider one
+                    if (a > b) {
+                        continue;
+                    }
+
+                    auto& qa = vertex_quadrics[a];
+                    auto& qb = vertex_quadrics[b];
+
+                    Collapse collapse{ 0, 0, FLT_MAX };
+                    if (!vertex_locked[a]) {
+                        collapse = { a, b, EvaluateQuadric(qa, qb, positions[b]) };
+                    }
+                    if (!vertex_locked[b]) {
+                        f32 error = EvaluateQuadric(qa, qb, positions[a]);
+                        if (error < collapse.error) {
+                            collapse = { b, a, error };
+                        }
+                    }
+
+                    if (collapse.error != FLT_MAX) {
+                        collapse.error = std::sqrt(collapse.error);
+                        collapses.push_back(collapse);
+                    }
+                }
+            }
+
+            if (collapses.empty()) {
+                break;
+            }
+
+            std::ranges::sort(collapses, {}, &Collapse::error);
+
+            // Select non-overlapping collapses
+
+            for (u32 i = 0; i < vertex_count; ++i) {
+                collapse_remap[i] = i;
+            }
+            collapse_touched.assign(vertex_count, 0);
+
+            u32 removed_triangles = 0;
+            u32 target_removed_triangles = (u32(out_indices.size()) - target_index_count + 2) / 3;
+            u32 applied_collapses = 0;
+
+            for (auto& collapse : collapses) {
+                if (collapse.error > max_error || removed_triangles >= target_removed_triangles) {
+                    break;
+                }
+
+                if (collapse_touched[collapse.from] || collapse_touched[collapse.to]) {
+                    continue;
+                }
+
+                // Reject collapses that flip or strongly rotate any remaining triangle
+
+                bool valid = true;
+                u32 collapsed_triangles = 0;
+                Vec3 new_position = positions[collapse.to];
+
+                for (u32 j = adjacency_offsets[collapse.from]; j < adjacency_offsets[collapse.from + 1]; ++j) {
+                    u32 tri = adjacency_triangles[j] * 3;
+                    u32 i0 = out_indices[tri + 0];
+                    u32 i1 = out_indices[tri + 1];
+                    u32 i2 = out_indices[tri + 2];
+
+                    if (i0 == collapse.to || i1 == collapse.to || i2 == collapse.to) {
+                        collapsed_triangles++;
+                        continue;
+                    }
+
+                    Vec3 p0 = positions[i0];
+                    Vec3 p1 = positions[i1];
+                    Vec3 p2 = positions[i2];
+                    Vec3 old_normal = glm::cross(p1 - p0, p2 - p0);
+
+                    if (i0 == collapse.from) p0 = new_position;
+                    if (i1 == collapse.from) p1 = new_position;
+                    if (i2 == collapse.from) p2 = new_position;
+                    Vec3 new_normal = glm::cross(p1 - p0, p2 - p0);
+
+                    if (glm::dot(old_normal, new_normal) < 0.25f * glm::length(old_normal) * glm::length(new_normal)) {
+                        valid = false;
+                        break;
+                    }
+                }
+
+                if (!valid) {
+                    continue;
+                }
+
+                collapse_remap[collapse.from] = collapse.to;
+                AddQuadric(vertex_quadrics[collapse.to], vertex_quadrics[collapse.from]);
+
+                // Lock the one-ring so that adjacency stays valid for the rest of this pass
+
+                for (u32 j = adjacency_offsets[collapse.from]; j < adjacency_offsets[collapse.from + 1]; ++j) {
+                    u32 tri = adjacency_triangles[j] * 3;
+                    collapse_touched[out_indices[tri + 0]] = 1;
+                    collapse_touched[out_indices[tri + 1]] = 1;
+                    collapse_touched[out_indices[tri + 2]] = 1;
+                }
+
+                removed_triangles += collapsed_triangles;
+                result_error = std::max(result_error, collapse.error);
+                applied_collapses++;
+            }
+
+            if (!applied_collapses) {
+                break;
+            }
+
+            // Remap indices and strip collapsed triangles
+
+            u32 write = 0;
+            for (u32 i = 0; i < triangle_count; ++i) {
+                u32 i0 = collapse_remap[out_indices[i * 3 + 0]];
+                u32 i1 = collapse_remap[out_indices[i * 3 + 1]];
+                u32 i2 = collapse_remap[out_indices[i * 3 + 2]];
+
+                if (i0 == i1 || i1 == i2 || i2 == i0) {
+                    continue;
+                }
+
+                out_indices[write++] = i0;
+                out_indices[write++] = i1;
+                out_indices[write++] = i2;
+            }
+            out_indices.resize(write);
+        }
+
+        return result_error;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <axiom_Core.hpp>
+
+namespace axiom
+{
+    class MeshSimplifier
+    {
+        struct Quadric
+        {
+            f64 a00, a01, a02, a03;
+            f64      a11, a12, a13;
+            f64           a22, a23;
+            f64                a33;
+            f64 weight;
+        };
+
+        struct Collapse
+        {
+            u32  from;
+            u32    to;
+            f32 error;
+        };
+
+        std::vector<Quadric>  vertex_quadrics;
+        std::vector<u8>         vertex_locked;
+        std::vector<u32>    adjacency_offsets;
+        std::vector<u32>   adjacency_triangles;
+        std::vector<Collapse>       collapses;
+        std::vector<u32>       collapse_remap;
+        std::vector<u8>      collapse_touched;
+
+    public:
+        // Simplifies an indexed triangle list using half-edge collapses ordered by
+        // quadric error. Vertices are never moved or created, so the output indexes
+        // the same vertex range as the input. Vertices on open borders and attribute
+        // seams (distinct vertices sharing a position) are locked in place, and
+        // collapses that would rotate a face normal past ~75 degrees are rejected.
+        //
+        // Returns the object space error of the simplified mesh
+        f32 Simplify(
+            nova::Span<const Vec3> positions,
+            nova::Span<const u32>    indices,
+            u32           target_index_count,
+            f32                    max_error,
+            std::vector<u32>&    out_indices);
+    };
+
+    inline thread_local MeshSimplifier S_MeshSimplifier;
+}
\ No newline at end of file
@@ -1,11 +1,479 @@
 #include "axiom_SceneCompiler.hpp"
+#include "axiom_MeshSimplifier.hpp"
 
+#include <nova/core/nova_Files.hpp>
+
+#include <charconv>
+#include <thread>
+
+namespace axiom
+{
+    namespace
+    {
+        struct WeldKey
+        {
+            u32                position[3];
+            ShadingAttributes shading;
+
+            bool operator==(const WeldKey& other) const noexcept
+            {
+                return std::memcmp(this, &other, sizeof(WeldKey)) == 0;
+            }
+        };
+
+        struct MaterialKey
+        {
+            u32 textures[5];
+            f32 alpha_cutoff;
+            u32        flags;
+
+            bool operator==(const MaterialKey& other) const noexcept
+            {
+                return std::memcmp(this, &other, sizeof(MaterialKey)) == 0;
+            }
+        };
+
+        struct TriangleIndicesKey
+        {
+            u32 indices[3];
+
+            bool operator==(const TriangleIndicesKey& other) const noexcept
+            {
+                return std::memcmp(indices, other.indices, sizeof(indices)) == 0;
+            }
+        };
+    }
+}
+NOVA_MEMORY_HASH(axiom::WeldKey);
+NOVA_MEMORY_HASH(axiom::MaterialKey);
+NOVA_MEMORY_HASH(axiom::TriangleIndicesKey);
 namespace axiom
 {
+    namespace
+    {
+        template<class T>
+        u64 HashContents(const std::vector<T>& data)
+        {
+            return ankerl::unordered_dense::detail::wyhash::hash(data.data(), data.size() * sizeof(T));
+        }
+
+        template<class T>
+        bool SameContents(const std::vector<T>& a, const std::vector<T>& b)
+        {
+            return a.size() == b.size()
+                && (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+        }
+
+        u32 GetCanonicalMaterial(const std::vector<u32>& canonical_materials, u32 material_idx)
+        {
+            return material_idx < canonical_materials.size() ? canonical_materials[material_idx] : material_idx;
+        }
+
+        // Spreads the low 10 bits of v to every third bit
+        u32 ExpandBits(u32 v)
+        {
+            v = (v * 0x00010001u) & 0xFF0000FFu;
+            v = (v * 0x00000101u) & 0x0F00F00Fu;
+            v = (v * 0x00000011u) & 0xC30C30C3u;
+            v = (v * 0x00000005u) & 0x49249249u;
+            return v;
+        }
+
+        // 30-bit Morton code for a point normalized to [0, 1]. NaNs map to 0
+        u32 MortonCode(Vec3 p)
+        {
+            auto Quantise = [](f32 v) {
+                return v > 0.f ? u32(std::min(v * 1024.f, 1023.f)) : 0u;
+            };
+            return ExpandBits(Quantise(p.x)) << 2
+                |  ExpandBits(Quantise(p.y)) << 1
+                |  ExpandBits(Quantise(p.z));
+        }
+
+// -----------------------------------------------------------------------------
+//                                 Mesh Cache
+// -----------------------------------------------------------------------------
+
+        // Increment when compiled mesh contents or the cache layout change
+        constexpr u32 MeshCacheVersion = 1;
+
+        const std::filesystem::path MeshCacheDir = "cache";
+
+        u64 HashMeshInputs(const scene_ir::Mesh& mesh, u64 options_hash)
+        {
+            std::vector<u64> hashes {
+                options_hash,
+                HashContents(mesh.positions),
+                HashContents(mesh.normals),
+                HashContents(mesh.tex_coords),
+                HashContents(mesh.indices),
+            };
+
+            return HashContents(hashes);
+        }
+
+        struct CachedMesh
+        {
+            u64       position_count;
+            u64      quantised_count;
+            u64        shading_count;
+            u64          index_count;
+            u64      index_u16_count;
+            u32       sub_mesh_count;
+            f32   quantisation_error;
+            Vec3          bounds_min;
+            Vec3          bounds_max;
+        };
+
+        struct CachedSubMesh
+        {
+            u32        vertex_offset;
+            u32           max_vertex;
+            u32          first_index;
+            u32          index_count;
+            nova::IndexType index_type;
+            Vec3          bounds_min;
+            Vec3          bounds_max;
+            Vec3     bounding_center;
+            f32      bounding_radius;
+            Vec3      dequant_offset;
+            Vec3       dequant_scale;
+            u32            lod_count;
+        };
+
+        void WriteMeshCache(const std::filesystem::path& path, const std::vector<TriMesh>& meshes, const SceneCompiler::MeshStats& stats)
+        {
+            // Written to a temporary file and renamed, so that interrupted writes are never read back
+
+            auto temp_path = path;
+            temp_path += std::format(".{:x}", std::hash<std::thread::id>{}(std::this_thread::get_id()));
+
+            {
+                nova::File file{ temp_path.string().c_str(), true };
+
+                file.Write(MeshCacheVersion);
+                file.Write(stats);
+                file.Write(u32(meshes.size()));
+
+                auto WriteVector = [&](const auto& v) {
+                    file.Write(v.data(), v.size() * sizeof(v[0]));
+                };
+
+                for (auto& mesh : meshes) {
+                    file.Write(CachedMesh {
+                        .position_count = mesh.position_attributes.size(),
+                        .quantised_count = mesh.quantised_positions.size(),
+                        .shading_count = mesh.shading_attributes.size(),
+                        .index_count = mesh.indices.size(),
+                        .index_u16_count = mesh.indices_u16.size(),
+                        .sub_mesh_count = u32(mesh.sub_meshes.size()),
+                        .quantisation_error = mesh.quantisation_error,
+                        .bounds_min = mesh.bounds_min,
+                        .bounds_max = mesh.bounds_max,
+                    });
+
+                    WriteVector(mesh.position_attributes);
+                    WriteVector(mesh.quantised_positions);
+                    WriteVector(mesh.shading_attributes);
+                    WriteVector(mesh.indices);
+                    WriteVector(mesh.indices_u16);
+
+                    for (auto& sub_mesh : mesh.sub_meshes) {
+                        file.Write(CachedSubMesh {
+                            .vertex_offset = sub_mesh.vertex_offset,
+                            .max_vertex = sub_mesh.max_vertex,
+                            .first_index = sub_mesh.first_index,
+                            .index_count = sub_mesh.index_count,
+                            .index_type = sub_mesh.index_type,
+                            .bounds_min = sub_mesh.bounds_min,
+                            .bounds_max = sub_mesh.bounds_max,
+                            .bounding_center = sub_mesh.bounding_center,
+                            .bounding_radius = sub_mesh.bounding_radius,
+                            .dequant_offset = sub_mesh.dequant_offset,
+                            .dequant_scale = sub_mesh.dequant_scale,
+                            .lod_count = u32(sub_mesh.lods.size()),
+                        });
+                        WriteVector(sub_mesh.lods);
+                    }
+                }
+            }
+
+            std::error_code ec;
+            std::filesystem::rename(temp_path, path, ec);
+            if (ec) {
+                std::filesystem::remove(temp_path, ec);
+            }
+        }
+
+        bool ReadMeshCache(const std::filesystem::path& path, std::vector<TriMesh>& meshes, SceneCompiler::MeshStats& stats)
+        {
+            std::error_code ec;
+            u64 remaining = std::filesystem::file_size(path, ec);
+            if (ec) {
+                return false;
+            }
+
+            nova::File file{ path.string().c_str() };
+
+            // Counts read from the file are checked against the bytes left before
+            // allocating, so that truncated or corrupt entries are treated as misses
+
+            auto Reserve = [&](u64 size) {
+                if (size > remaining) {
+                    return false;
+                }
+                remaining -= size;
+                return true;
+            };
+
+            auto Read = [&](auto& value) {
+                if (!Reserve(sizeof(value))) {
+                    return false;
+                }
+                file.Read(value);
+                return true;
+            };
+
+            auto ReadVector = [&](auto& v, u64 count) {
+                if (count > remaining / sizeof(v[0]) || !Reserve(count * sizeof(v[0]))) {
+                    return false;
+                }
+                v.resize(count);
+                file.Read(v.data(), count * sizeof(v[0]));
+                return true;
+            };
+
+            u32 version;
+            if (!Read(version) || version != MeshCacheVersion) {
+                return false;
+            }
+
+            SceneCompiler::MeshStats cached_stats;
+            u32 mesh_count;
+            if (!Read(cached_stats) || !Read(mesh_count) || mesh_count > remaining / sizeof(CachedMesh)) {
+                return false;
+            }
+
+            meshes.resize(mesh_count);
+            for (auto& mesh : meshes) {
+                CachedMesh cached;
+                if (!Read(cached)
+                        || !ReadVector(mesh.position_attributes, cached.position_count)
+                        || !ReadVector(mesh.quantised_positions, cached.quantised_count)
+                        || !ReadVector(mesh.shading_attributes, cached.shading_count)
+                        || !ReadVector(mesh.indices, cached.index_count)
+                        || !ReadVector(mesh.indices_u16, cached.index_u16_count)
+                        || cached.sub_mesh_count > remaining / sizeof(CachedSubMesh)) {
+                    meshes.clear();
+                    return false;
+                }
+                mesh.quantisation_error = cached.quantisation_error;
+                mesh.bounds_min = cached.bounds_min;
+                mesh.bounds_max = cached.bounds_max;
+
+                mesh.sub_meshes.resize(cached.sub_mesh_count);
+                for (auto& sub_mesh : mesh.sub_meshes) {
+                    CachedSubMesh cached_sub_mesh;
+                    if (!Read(cached_sub_mesh)) {
+                        meshes.clear();
+                        return false;
+                    }
+
+                    sub_mesh.vertex_offset = cached_sub_mesh.vertex_offset;
+                    sub_mesh.max_vertex = cached_sub_mesh.max_vertex;
+                    sub_mesh.first_index = cached_sub_mesh.first_index;
+                    sub_mesh.index_count = cached_sub_mesh.index_count;
+                    sub_mesh.index_type = cached_sub_mesh.index_type;
+                    sub_mesh.bounds_min = cached_sub_mesh.bounds_min;
+                    sub_mesh.bounds_max = cached_sub_mesh.bounds_max;
+                    sub_mesh.bounding_center = cached_sub_mesh.bounding_center;
+                    sub_mesh.bounding_radius = cached_sub_mesh.bounding_radius;
+                    sub_mesh.dequant_offset = cached_sub_mesh.dequant_offset;
+                    sub_mesh.dequant_scale = cached_sub_mesh.dequant_scale;
+                    if (!ReadVector(sub_mesh.lods, cached_sub_mesh.lod_count)) {
+                        meshes.clear();
+                        return false;
+                    }
+                }
+            }
+
+            stats = cached_stats;
+            return true;
+        }
+
+        // Each compiled source keeps a manifest of the mesh entries it last used, replaced
+        // on every compile of that source. Entries not listed by any manifest are pruned
+
+        constexpr std::string_view MeshEntryPrefix     = "mesh$";
+        constexpr std::string_view ManifestEntryPrefix = "manifest$";
+
+        std::filesystem::path GetMeshManifestPath(std::string_view source)
+        {
+            return MeshCacheDir / std::format("{}{:016x}", ManifestEntryPrefix,
+                ankerl::unordered_dense::detail::wyhash::hash(source.data(), source.size()));
+        }
+
+        void WriteMeshManifest(const std::filesystem::path& path, const std::vector<u64>& mesh_hashes)
+        {
+            auto temp_path = path;
+            temp_path += std::format(".{:x}", std::hash<std::thread::id>{}(std::this_thread::get_id()));
+
+            {
+                nova::File file{ temp_path.string().c_str(), true };
+                file.Write(MeshCacheVersion);
+                file.Write(u64(mesh_hashes.size()));
+                file.Write(mesh_hashes.data(), mesh_hashes.size() * sizeof(u64));
+            }
+
+            std::error_code ec;
+            std::filesystem::rename(temp_path, path, ec);
+            if (ec) {
+                std::filesystem::remove(temp_path, ec);
+            }
+        }
+
+        void ReadMeshManifest(const std::filesystem::path& path, ankerl::unordered_dense::set<u64>& mesh_hashes)
+        {
+            std::error_code ec;
+            u64 size = std::filesystem::file_size(path, ec);
+            if (ec || size < sizeof(u32) + sizeof(u64)) {
+                return;
+            }
+
+            nova::File file{ path.string().c_str() };
+
+            u32 version;
+            file.Read(version);
+            if (version != MeshCacheVersion) {
+                return;
+            }
+
+            u64 count;
+            file.Read(count);
+            if (count > (size - sizeof(u32) - sizeof(u64)) / sizeof(u64)) {
+                return;
+            }
+            std::vector<u64> hashes(count);
+            file.Read(hashes.data(), count * sizeof(u64));
+            mesh_hashes.insert(hashes.begin(), hashes.end());
+        }
+
+        // Returns the hash encoded in a cache entry name, ignoring temporary files
+        std::optional<u64> ParseEntryHash(std::string_view name, std::string_view prefix)
+        {
+            if (!name.starts_with(prefix)) {
+                return std::nullopt;
+            }
+
+            name.remove_prefix(prefix.size());
+            u64 hash;
+            auto[end, ec] = std::from_chars(name.data(), name.data() + name.size(), hash, 16);
+            if (ec != std::errc{} || end != name.data() + name.size()) {
+                return std::nullopt;
+            }
+
+            return hash;
+        }
+
+        void PruneMeshCache()
+        {
+            ankerl::unordered_dense::set<u64> referenced;
+            std::vector<std::filesystem::path> mesh_entries;
+
+            std::error_code ec;
+            for (auto& entry : std::filesystem::directory_iterator(MeshCacheDir, ec)) {
+                auto name = entry.path().filename().string();
+                if (ParseEntryHash(name, ManifestEntryPrefix)) {
+                    ReadMeshManifest(entry.path(), referenced);
+                } else if (ParseEntryHash(name, MeshEntryPrefix)) {
+                    mesh_entries.push_back(entry.path());
+                }
+            }
+
+            u32 pruned = 0;
+            for (auto& path : mesh_entries) {
+                if (!referenced.contains(*ParseEntryHash(path.filename().string(), MeshEntryPrefix))) {
+                    std::filesystem::remove(path, ec);
+                    pruned++;
+                }
+            }
+
+            if (pruned) {
+                NOVA_LOG("Pruned {} unreferenced mesh cache entries", pruned);
+            }
+        }
+    }
+
+    u64 SceneCompiler::HashMeshOptions()
+    {
+        // Only options that affect individual compiled meshes. Hashed field by field,
+        // so that padding never contributes to the key
+
+        std::vector<u64> options {
+            MeshCacheVersion,
+            split_triangle_threshold,
+            lod_levels,
+            std::bit_cast<u32>(lod_target_ratio),
+            std::bit_cast<u32>(lod_max_error),
+            flip_uvs,
+            weld_vertices,
+            reorder_triangles,
+            compact_indices,
+            quantise_positions,
+            sanitise_meshes,
+        };
+
+        return HashContents(options);
+    }
+
+    void SceneCompiler::BuildTextureUsage(const scene_ir::Scene& scene, TextureUsageGraph& graph)
+    {
+        graph.textures.assign(scene.textures.size(), {});
+        graph.material_textures.resize(scene.materials.size());
+
+        for (u32 material_idx = 0; material_idx < scene.materials.size(); ++material_idx) {
+            auto& material = scene.materials[material_idx];
+            auto& slots = graph.material_textures[material_idx];
+            slots.fill(scene_ir::InvalidIndex);
+
+            auto Bind = [&](TextureRole role, scene_ir::PropertyKey key) {
+                if (slots[u32(role)] != scene_ir::InvalidIndex) {
+                    return;
+                }
+
+                auto swizzle = material.GetProperty<scene_ir::TextureSwizzle>(key);
+                if (!swizzle || swizzle->texture_idx >= scene.textures.size()) {
+                    return;
+                }
+
+                slots[u32(role)] = swizzle->texture_idx;
+
+                graph.textures[swizzle->texture_idx].roles |= 1u << u32(role);
+            };
+
+            Bind(TextureRole::BaseColor, scene_ir::property::BaseColor);
+            Bind(TextureRole::Normal, scene_ir::property::Normal);
+            Bind(TextureRole::Emissive, scene_ir::property::Emissive);
+            Bind(TextureRole::MetalnessRoughness, scene_ir::property::Metallic);
+            Bind(TextureRole::MetalnessRoughness, scene_ir::property::SpecularColor);
+            Bind(TextureRole::Transmission, scene_ir::property::Transmission);
+        }
+    }
+
     void SceneCompiler::Compile(scene_ir::Scene& in_scene, CompiledScene& out_scene)
     {
-        auto default_material = Ref<UVMaterial>::Create();
-        out_scene.materials.push_back(default_material);
+        CompileScene(in_scene, out_scene, false);
+    }
+
+    void SceneCompiler::Compile(scene_ir::Scene&& in_scene, CompiledScene& out_scene)
+    {
+        CompileScene(in_scene, out_scene, true);
+    }
+
+    void SceneCompiler::CompileScene(scene_ir::Scene& in_scene, CompiledScene& out_scene, bool consume)
+    {
+        Index<UVMaterial> default_material = out_scene.materials.size();
+        out_scene.materials.emplace_back();
 
         // BaseColor + Alpha = BC7
         // Normals           = BC5
@@ -16,21 +484,44 @@ namespace axiom
         u32 texture_offset = u32(out_scene.textures.size());
 
         out_scene.textures.resize(texture_offset + in_scene.textures.size());
-#pragma omp parallel for
+
+        TextureUsageGraph usage;
+        BuildTextureUsage(in_scene, usage);
+
+#pragma omp parallel for schedule(dynamic)
         for (u32 i = 0; i < in_scene.textures.size(); ++i) {
             auto& in_texture = in_scene.textures[i];
-            auto out_texture = Ref<UVTexture>::Create();
-            out_scene.textures[texture_offset + i] = out_texture;
+            auto& out_texture = out_scene.textures[texture_offset + i];
+            auto& texture_usage = usage.textures[i];
 
-            ImageProcess processes = {};
-            if (flip_normal_map_z) {
-                for (auto& material : in_scene.materials) {
-                    // TODO: This should follow the mapping process
-                    if (auto p = material.GetProperty<scene_ir::TextureSwizzle>(scene_ir::property::Normal); p && p->texture_idx == i) {
-                        processes |= ImageProcess::FlipNrmZ;
-                        break;
-                    }
+            // Textures not sampled by any material are left empty
+
+            if (!texture_usage.roles) {
+                if (consume) {
+                    in_texture.data = {};
                 }
+                continue;
+            }
+
+            // Alpha is only analysed for base color textures, other roles are
+            // processed by their first use
+
+            ImageType type = ImageType::ColorAlpha;
+            if (!texture_usage.HasRole(TextureRole::BaseColor)) {
+                if (texture_usage.HasRole(TextureRole::Normal)) {
+                    type = ImageType::Normal;
+                } else if (texture_usage.HasRole(TextureRole::Emissive)) {
+                    type = ImageType::ColorHDR;
+                } else if (texture_usage.HasRole(TextureRole::MetalnessRoughness)) {
+                    type = ImageType::Scalar2;
+                } else {
+                    type = ImageType::Scalar1;
+                }
+            }
+
+            ImageProcess processes = {};
+            if (flip_normal_map_z && texture_usage.HasRole(TextureRole::Normal)) {
+                processes |= ImageProcess::FlipNrmZ;
             }
 
             // constexpr u32 MaxDim = 512;
@@ -46,19 +537,23 @@ namespace axiom
                     continue;
                 }
                 path = std::filesystem::canonical(path);
-                S_ImageProcessor.ProcessImage(path.string().c_str(), 0, ImageType::ColorAlpha, MaxDim, processes);
+                S_ImageProcessor.ProcessImage(path.string().c_str(), 0, type, MaxDim, processes);
             } else if (auto file = std::get_if<scene_ir::ImageFileBuffer>(&in_texture.data)) {
-                S_ImageProcessor.ProcessImage((const char*)file->data.data(), file->data.size(), ImageType::ColorAlpha, MaxDim, {});
+                S_ImageProcessor.ProcessImage((const char*)file->data.data(), file->data.size(), type, MaxDim, processes);
             } else if (auto buffer = std::get_if<scene_ir::ImageBuffer>(&in_texture.data)) {
                 NOVA_THROW("Buffer data source not currently supported");
             }
 
-            out_texture->data.resize(S_ImageProcessor.GetImageDataSize());
-            std::memcpy(out_texture->data.data(), S_ImageProcessor.GetImageData(), out_texture->data.size());
-            out_texture->size = S_ImageProcessor.GetImageDimensions();
-            out_texture->min_alpha = S_ImageProcessor.GetMinAlpha();
-            out_texture->max_alpha = S_ImageProcessor.GetMaxAlpha();
-            out_texture->format = S_ImageProcessor.GetImageFormat();
+            out_texture.data.resize(S_ImageProcessor.GetImageDataSize());
+            std::memcpy(out_texture.data.data(), S_ImageProcessor.GetImageData(), out_texture.data.size());
+
+            if (consume) {
+                in_texture.data = {};
+            }
+            out_texture.size = S_ImageProcessor.GetImageDimensions();
+            out_texture.min_alpha = S_ImageProcessor.GetMinAlpha();
+            out_texture.max_alpha = S_ImageProcessor.GetMaxAlpha();
+            out_texture.format = S_ImageProcessor.GetImageFormat();
         }
 
         nova::HashMap<u32, u32> single_pixel_textures;
@@ -74,44 +569,49 @@ namespace axiom
             u32 encoded = std::bit_cast<u32>(data);
 
             if (single_pixel_textures.contains(encoded)) {
-                return out_scene.textures[single_pixel_textures.at(encoded)];
+                return Index<UVTexture>(single_pixel_textures.at(encoded));
             }
 
-            auto image = Ref<UVTexture>::Create();
-            image->size = Vec2(1);
-            image->data = { b8(data[0]), b8(data[1]), b8(data[2]), b8(data[3]) };
+            Index<UVTexture> image = out_scene.textures.size();
+            auto& texture = out_scene.textures.emplace_back();
+            texture.size = Vec2(1);
+            texture.data = { b8(data[0]), b8(data[1]), b8(data[2]), b8(data[3]) };
 
-            out_scene.textures.push_back(image);
-            single_pixel_textures.insert({ encoded, u32(out_scene.textures.size() - 1) });
+            single_pixel_textures.insert({ encoded, image.value });
 
             return image;
         };
 
-        default_material->basecolor_alpha = CreatePixelImage({ 1.f, 0.f, 1.f, 1.f });
-        default_material->normals = CreatePixelImage({ 0.5f, 0.5f, 1.f, 1.f });
-        default_material->metalness_roughness = CreatePixelImage({ 0.f, 0.5f, 0.f, 1.f });
-        default_material->emissivity = CreatePixelImage({ 0.f, 0.f, 0.f, 1.f });
-        default_material->transmission = CreatePixelImage({ 0.f, 0.f, 0.f, 255.f });
+        UVMaterial fallback;
+        fallback.basecolor_alpha = CreatePixelImage({ 1.f, 0.f, 1.f, 1.f });
+        fallback.normals = CreatePixelImage({ 0.5f, 0.5f, 1.f, 1.f });
+        fallback.metalness_roughness = CreatePixelImage({ 0.f, 0.5f, 0.f, 1.f });
+        fallback.emissivity = CreatePixelImage({ 0.f, 0.f, 0.f, 1.f });
+        fallback.transmission = CreatePixelImage({ 0.f, 0.f, 0.f, 255.f });
+        out_scene.Get(default_material) = fallback;
 
         auto total_base_color = 0;
 
         u32 material_offset = u32(out_scene.materials.size());
-        for (auto& in_material : in_scene.materials) {
-            auto out_material = Ref<UVMaterial>::Create();
-            out_scene.materials.push_back(out_material);
+        for (u32 material_idx = 0; material_idx < in_scene.materials.size(); ++material_idx) {
+            auto& in_material = in_scene.materials[material_idx];
+            auto& out_material = out_scene.materials.emplace_back();
 
-            auto GetImage = [&](std::string_view property, nova::types::Ref<UVTexture> fallback) {
+            auto GetTexture = [&](TextureRole role) -> Index<UVTexture> {
+                u32 texture_idx = usage.Get(material_idx, role);
+                if (texture_idx == scene_ir::InvalidIndex || out_scene.textures[texture_offset + texture_idx].data.empty()) {
+                    return {};
+                }
+                return texture_offset + texture_idx;
+            };
 
-                auto* texture = in_material.GetProperty<scene_ir::TextureSwizzle>(property);
+            auto GetImage = [&](TextureRole role, scene_ir::PropertyKey property, Index<UVTexture> fallback) {
 
-                if (texture) {
-                    auto tex = out_scene.textures[texture_offset + texture->texture_idx];
-                    if (tex->data.size()) {
-                        if (property == scene_ir::property::BaseColor) {
-                            total_base_color++;
-                        }
-                        return tex;
+                if (auto tex = GetTexture(role); tex.IsValid()) {
+                    if (role == TextureRole::BaseColor) {
+                        total_base_color++;
                     }
+                    return tex;
                 }
 
                 // NOVA_LOG("Using fallback!");
@@ -135,17 +635,13 @@ namespace axiom
 
             // TODO: Channel remapping!
 
-            out_material->basecolor_alpha = GetImage(scene_ir::property::BaseColor, default_material->basecolor_alpha);
-            out_material->normals = GetImage(scene_ir::property::Normal, default_material->normals);
+            out_material.basecolor_alpha = GetImage(TextureRole::BaseColor, scene_ir::property::BaseColor, fallback.basecolor_alpha);
+            out_material.normals = GetImage(TextureRole::Normal, scene_ir::property::Normal, fallback.normals);
             {
-                if (auto* tex = in_material.GetProperty<scene_ir::TextureSwizzle>(scene_ir::property::Metallic);
-                        tex && out_scene.textures[texture_offset + tex->texture_idx]->data.size()) {
-                    // TODO: Fixme
-                    out_material->metalness_roughness = out_scene.textures[texture_offset + tex->texture_idx];
-                } else if (tex = in_material.GetProperty<scene_ir::TextureSwizzle>(scene_ir::property::SpecularColor);
-                        tex && out_scene.textures[texture_offset + tex->texture_idx]->data.size()) {
+                // Metallic or specular color texture, see BuildTextureUsage
+                if (auto tex = GetTexture(TextureRole::MetalnessRoughness); tex.IsValid()) {
                     // TODO: Fixme
-                    out_material->metalness_roughness = out_scene.textures[texture_offset + tex->texture_idx];
+                    out_material.metalness_roughness = tex;
                 } else {
                     auto* _metalness = in_material.GetProperty<f32>(scene_ir::property::Metallic);
                     auto* _roughness = in_material.GetProperty<f32>(scene_ir::property::Roughness);
@@ -153,113 +649,1549 @@ namespace axiom
                     f32 metalness = _metalness ? *_metalness : 0.f;
                     f32 roughness = _roughness ? *_roughness : 0.5f;
 
-                    out_material->metalness_roughness = CreatePixelImage({ 0.f, roughness, metalness, 1.f });
+                    out_material.metalness_roughness = CreatePixelImage({ 0.f, roughness, metalness, 1.f });
                 }
             }
-            out_material->emissivity = GetImage(scene_ir::property::Emissive, default_material->emissivity);
-            out_material->transmission = GetImage("", default_material->transmission);
+            out_material.emissivity = GetImage(TextureRole::Emissive, scene_ir::property::Emissive, fallback.emissivity);
+            out_material.transmission = GetImage(TextureRole::Transmission, scene_ir::property::Transmission, fallback.transmission);
 
-            out_material->alpha_cutoff = [](f32*v){return v?*v:0.5f;}(in_material.GetProperty<f32>(scene_ir::property::AlphaCutoff));
+            out_material.alpha_cutoff = [](f32*v){return v?*v:0.5f;}(in_material.GetProperty<f32>(scene_ir::property::AlphaCutoff));
 
-            out_material->alpha_mask = in_material.GetProperty<bool>(scene_ir::property::AlphaMask) ||
-                out_material->basecolor_alpha->min_alpha < out_material->alpha_cutoff;
+            out_material.alpha_mask = in_material.GetProperty<bool>(scene_ir::property::AlphaMask) ||
+                out_scene.Get(out_material.basecolor_alpha).min_alpha < out_material.alpha_cutoff;
         }
 
         NOVA_LOGEXPR(total_base_color);
 
-        u64 total_tangent_spaces = 0;
-        ankerl::unordered_dense::set<u64> unique_tangent_space;
+        // Materials with identical compiled contents are shared. canonical_materials maps
+        // each source material to the first equivalent one, so that passes matching or
+        // batching meshes by material treat them as equal without modifying the source
+
+        std::vector<Index<UVMaterial>> material_remap(in_scene.materials.size());
+        std::vector<u32> canonical_materials(in_scene.materials.size());
+        {
+            auto& canonical = canonical_materials;
+            nova::HashMap<MaterialKey, u32> unique_materials;
+            u32 unique_count = 0;
+
+            for (u32 i = 0; i < in_scene.materials.size(); ++i) {
+                UVMaterial material = out_scene.materials[material_offset + i];
+
+                if (deduplicate_materials) {
+                    MaterialKey key = {};
+                    key.textures[0] = material.basecolor_alpha.value;
+                    key.textures[1] = material.normals.value;
+                    key.textures[2] = material.emissivity.value;
+                    key.textures[3] = material.transmission.value;
+                    key.textures[4] = material.metalness_roughness.value;
+                    key.alpha_cutoff = material.alpha_cutoff;
+                    key.flags = u32(material.alpha_mask)
+                        | u32(material.alpha_blend) << 1
+                        | u32(material.thin)        << 2
+                        | u32(material.subsurface)  << 3
+                        | u32(material.decal)       << 4;
+
+                    auto[iter, inserted] = unique_materials.insert({ key, i });
+                    if (!inserted) {
+                        canonical[i] = iter->second;
+                        material_remap[i] = material_remap[iter->second];
+                        continue;
+                    }
+                }
+
+                canonical[i] = i;
+                material_remap[i] = material_offset + unique_count;
+                out_scene.materials[material_offset + unique_count++] = material;
+            }
+
+            out_scene.materials.resize(material_offset + unique_count);
+
+            if (deduplicate_materials) {
+                NOVA_LOG("Deduplicated materials: {} -> {}", in_scene.materials.size(), unique_count);
+            }
+        }
+
+        // Passes that add meshes or replace instances write to compiler owned storage,
+        // so that the input scene is only modified when consumed. Mesh indices past the
+        // end of the input meshes refer to batch_meshes
+
+        std::vector<scene_ir::Mesh>         batch_meshes;
+        std::vector<scene_ir::Instance> batch_instances;
+
+        u32 source_mesh_count = u32(in_scene.meshes.size());
+        u32 mesh_count = source_mesh_count;
+        std::span<const scene_ir::Instance> instances = in_scene.instances;
+
+        // Source meshes that needed changes are replaced by sanitised copies unless consumed
+
+        std::vector<scene_ir::Mesh> sanitised_meshes(consume ? 0 : source_mesh_count);
+        std::vector<u8> sanitised(source_mesh_count, 0);
+
+        auto GetMesh = [&](u32 mesh_idx) -> scene_ir::Mesh& {
+            if (mesh_idx >= source_mesh_count) {
+                return batch_meshes[mesh_idx - source_mesh_count];
+            }
+            return sanitised[mesh_idx] ? sanitised_meshes[mesh_idx] : in_scene.meshes[mesh_idx];
+        };
+
+        // Only non-empty meshes referenced by instances are compiled
+
+        std::vector<u8> referenced;
+        auto FindReferencedMeshes = [&] {
+            referenced.assign(mesh_count, 0);
+            for (auto& in_instance : instances) {
+                for (u32 i = 0; i < in_instance.mesh_count; ++i) {
+                    u32 mesh_idx = in_instance.mesh_idx + i;
+                    referenced[mesh_idx] = !GetMesh(mesh_idx).indices.empty();
+                }
+            }
+        };
+        FindReferencedMeshes();
+
+        // Sanitised before any pass that reads mesh contents. Every referenced mesh is
+        // sanitised, whether or not its compiled result is later read from the cache
+
+        std::vector<SanitiseStats> sanitise_stats(source_mesh_count);
+        if (sanitise_meshes) {
+#pragma omp parallel for schedule(dynamic)
+            for (u32 mesh_idx = 0; mesh_idx < source_mesh_count; ++mesh_idx) {
+                if (!referenced[mesh_idx]) {
+                    continue;
+                }
+
+                auto& stats = sanitise_stats[mesh_idx];
+                if (consume) {
+                    SanitiseMesh(in_scene.meshes[mesh_idx], stats);
+                    continue;
+                }
+
+                // Copies are only kept for meshes that were changed, as reported by stats
+                scene_ir::Mesh copy = in_scene.meshes[mesh_idx];
+                SanitiseMesh(copy, stats);
+                if (stats.non_finite_positions || stats.invalid_attributes || stats.out_of_range_triangles
+                        || stats.degenerate_triangles || stats.duplicate_triangles || stats.trimmed_vertices) {
+                    sanitised_meshes[mesh_idx] = std::move(copy);
+                    sanitised[mesh_idx] = 1;
+                }
+            }
+
+            // Meshes left without triangles are no longer referenced
+            FindReferencedMeshes();
+        }
+
+        std::vector<const scene_ir::Mesh*> meshes(source_mesh_count);
+        for (u32 mesh_idx = 0; mesh_idx < source_mesh_count; ++mesh_idx) {
+            meshes[mesh_idx] = &GetMesh(mesh_idx);
+        }
+
+        // Identical and rigidly transformed copies are redirected to a canonical mesh,
+        // so that each distinct mesh is only compiled once
+
+        std::vector<RigidMatch> rigid_matches(in_scene.meshes.size());
+        for (u32 i = 0; i < in_scene.meshes.size(); ++i) {
+            rigid_matches[i] = { i, Mat4(1.f) };
+        }
+        if (deduplicate_meshes) {
+            DeduplicateMeshes(meshes, canonical_materials, referenced, rigid_matches);
+        }
+        if (deduplicate_rigid_meshes) {
+            FindRigidMatches(meshes, canonical_materials, referenced, rigid_matches);
+        }
+
+        if (flatten_unique_instances && FlattenInstances(meshes, instances, canonical_materials, rigid_matches, batch_meshes, batch_instances)) {
+            mesh_count = source_mesh_count + u32(batch_meshes.size());
+            instances = batch_instances;
+
+            // Batches are built from sanitised meshes, but transforms can still collapse
+            // triangles, so are sanitised again
+            if (sanitise_meshes) {
+                sanitise_stats.resize(mesh_count);
+#pragma omp parallel for schedule(dynamic)
+                for (u32 i = 0; i < batch_meshes.size(); ++i) {
+                    SanitiseMesh(batch_meshes[i], sanitise_stats[source_mesh_count + i]);
+                }
+            }
+
+            FindReferencedMeshes();
+        }
+
+        // Instances reference meshes through mesh_remap, so that passes can redirect
+        // them to shared, merged or split meshes
+
+        std::vector<MeshRemap> mesh_remap(mesh_count);
+
+        // Meshes are compiled independently so that results can be cached per source
+        // mesh, keyed on mesh contents and options. Materials are assigned afterwards
+        // and are not part of the key. Without a source, this compile's manifest would
+        // replace that of every other unnamed compile, so nothing is cached
+
+        bool use_cache = cache_meshes && !cache_source.empty();
+        if (use_cache) {
+            std::filesystem::create_directories(MeshCacheDir);
+        }
+
+        u64 options_hash = HashMeshOptions();
+
+        std::vector<std::vector<TriMesh>> compiled(mesh_count);
+        std::vector<MeshStats> mesh_stats(mesh_count);
+        std::vector<u64> mesh_hashes(mesh_count);
+
+        // Exceptions can't leave the parallel region, failures are rethrown after it
+        std::vector<std::string> mesh_errors(mesh_count);
+
+#pragma omp parallel for schedule(dynamic)
+        for (u32 mesh_idx = 0; mesh_idx < mesh_count; ++mesh_idx) {
+            if (!referenced[mesh_idx] || rigid_matches[mesh_idx].canonical_idx != mesh_idx) {
+                continue;
+            }
+
+            // Batch meshes and sanitised copies are owned by the compiler, and can always be consumed
+            bool consume_mesh = consume || mesh_idx >= source_mesh_count || sanitised[mesh_idx];
+
+            auto& in_mesh = GetMesh(mesh_idx);
+            auto& out_meshes = compiled[mesh_idx];
+            auto& stats = mesh_stats[mesh_idx];
+
+            std::filesystem::path cache_path;
+            if (use_cache) {
+                mesh_hashes[mesh_idx] = HashMeshInputs(in_mesh, options_hash);
+                cache_path = MeshCacheDir / std::format("{}{:016x}", MeshEntryPrefix, mesh_hashes[mesh_idx]);
+                stats.cached = ReadMeshCache(cache_path, out_meshes, stats);
+            }
+
+            if (!stats.cached) {
+                try {
+                    CompileMesh(in_mesh, consume_mesh, out_meshes, stats);
+                } catch (const std::exception& e) {
+                    mesh_errors[mesh_idx] = e.what();
+                    continue;
+                }
+                if (use_cache) {
+                    WriteMeshCache(cache_path, out_meshes, stats);
+                }
+            }
+
+            Index<UVMaterial> material = in_mesh.material_idx == scene_ir::InvalidIndex
+                ? default_material
+                : material_remap[in_mesh.material_idx];
+            for (auto& mesh : out_meshes) {
+                for (auto& sub_mesh : mesh.sub_meshes) {
+                    sub_mesh.material = material;
+                }
+            }
+
+            if (consume_mesh) {
+                in_mesh = {};
+            }
+        }
+
+        for (u32 mesh_idx = 0; mesh_idx < mesh_count; ++mesh_idx) {
+            if (!mesh_errors[mesh_idx].empty()) {
+                NOVA_THROW("Failed to compile mesh {}: {}", mesh_idx, mesh_errors[mesh_idx]);
+            }
+        }
+
+        if (use_cache) {
+            std::vector<u64> used_hashes;
+            for (u64 hash : mesh_hashes) {
+                if (hash) {
+                    used_hashes.push_back(hash);
+                }
+            }
+            WriteMeshManifest(GetMeshManifestPath(cache_source), used_hashes);
+            PruneMeshCache();
+        }
 
         u32 mesh_offset = u32(out_scene.meshes.size());
-        for (auto& in_mesh : in_scene.meshes) {
-            auto out_mesh = Ref<TriMesh>::Create();
-            out_scene.meshes.push_back(out_mesh);
-
-            out_mesh->position_attributes.resize(in_mesh.positions.size());
-            std::memcpy(out_mesh->position_attributes.data(),
-                in_mesh.positions.data(), in_mesh.positions.size() * sizeof(Vec3));
-
-            out_mesh->shading_attributes.resize(in_mesh.positions.size());
-            for (u32 i : in_mesh.indices) out_mesh->indices.push_back(i);
-
-            usz vertex_count = out_mesh->position_attributes.size();
-            usz index_count = out_mesh->indices.size();
-
-            S_MeshProcessor.flip_uvs = flip_uvs;
-            S_MeshProcessor.ProcessMesh(
-                { &out_mesh->position_attributes[0], sizeof(out_mesh->position_attributes[0]), vertex_count },
-                !in_mesh.normals.empty()
-                    ? InStridedRegion{ &in_mesh.normals[0], sizeof(in_mesh.normals[0]), vertex_count }
-                    : InStridedRegion{},
-                !in_mesh.tex_coords.empty()
-                    ? InStridedRegion{ &in_mesh.tex_coords[0], sizeof(in_mesh.tex_coords[0]), vertex_count }
-                    : InStridedRegion{},
-                { &out_mesh->indices[0], sizeof(out_mesh->indices[0]), index_count },
-                { &out_mesh->shading_attributes[0].tangent_space, sizeof(out_mesh->shading_attributes[0]), vertex_count },
-                { &out_mesh->shading_attributes[0].tex_coords, sizeof(out_mesh->shading_attributes[0]), vertex_count });
-
-            for (u32 i = 0; i < vertex_count; ++i) {
-                total_tangent_spaces++;
-                std::pair<u32, u32> ts;
-                ts.first = std::bit_cast<u32>(out_mesh->shading_attributes[i].tangent_space);
-                ts.second = std::bit_cast<u32>(out_mesh->shading_attributes[i].tex_coords);
-                unique_tangent_space.insert(std::bit_cast<u64>(ts));
-            }
-
-            out_mesh->sub_meshes.push_back(TriSubMesh {
-                .vertex_offset = 0,
-                .max_vertex = u32(in_mesh.positions.size() - 1),
-                .first_index = 0,
-                .index_count = u32(in_mesh.indices.size()),
-                .material = in_mesh.material_idx == scene_ir::InvalidIndex
-                    ? out_scene.materials[material_offset - 1]
-                    : out_scene.materials[material_offset + in_mesh.material_idx],
-            });
+        for (u32 mesh_idx = 0; mesh_idx < mesh_count; ++mesh_idx) {
+            for (auto& mesh : compiled[mesh_idx]) {
+                mesh_remap[mesh_idx].meshes.push_back(out_scene.meshes.size());
+                out_scene.meshes.push_back(std::move(mesh));
+            }
         }
+        compiled = {};
 
-        NOVA_LOG("Unique shading attributes: {} / {} ({:.2f}%)", unique_tangent_space.size(), total_tangent_spaces, (100.0 * unique_tangent_space.size()) / total_tangent_spaces);
+        for (u32 i = 0; i < mesh_count; ++i) {
+            auto& match = rigid_matches[i];
+            if (referenced[i] && match.canonical_idx != i) {
+                mesh_remap[i] = { mesh_remap[match.canonical_idx].meshes, match.transform };
+            }
+        }
 
-        for (auto& in_instance : in_scene.instances) {
-            auto out_instance = Ref<TriMeshInstance>::Create();
-            out_scene.instances.push_back(out_instance);
+        // Remaining source meshes are either unreferenced or rigid copies, and are
+        // no longer needed once their remaps are known
 
-            out_instance->mesh = out_scene.meshes[mesh_offset + in_instance.mesh_idx];
-            out_instance->transform = in_instance.transform;
+        batch_meshes = {};
+        sanitised_meshes = {};
+        if (consume) {
+            in_scene.meshes = {};
         }
 
-        // {
-        //     auto joined_mesh = Ref<TriMesh>::Create();
+        if (sanitise_meshes) {
+            SanitiseStats stats;
+            for (auto& s : sanitise_stats) {
+                stats.non_finite_positions += s.non_finite_positions;
+                stats.invalid_attributes += s.invalid_attributes;
+                stats.out_of_range_triangles += s.out_of_range_triangles;
+                stats.degenerate_triangles += s.degenerate_triangles;
+                stats.duplicate_triangles += s.duplicate_triangles;
+                stats.trimmed_vertices += s.trimmed_vertices;
+            }
 
-        //     for (auto& in_instance : in_scene.instances) {
-        //         auto& in_mesh = out_scene.meshes[in_instance.mesh_idx];
-        //         u32 vertex_offset = u32(joined_mesh->position_attributes.size());
-        //         u32 index_offset = u32(joined_mesh->indices.size());
-        //         for (u32 i = 0; i < in_mesh->position_attributes.size(); ++i) {
-        //             auto pos = in_mesh->position_attributes[i];
-        //             auto sa = in_mesh->shading_attributes[i];
-        //             joined_mesh->position_attributes.push_back(in_instance.transform * Vec4(pos, 1.f));
-        //             joined_mesh->shading_attributes.push_back(sa);
-        //         }
-        //         for (u32 i = 0; i < in_mesh->indices.size(); ++i) {
-        //             auto index = in_mesh->indices[i];
-        //             joined_mesh->indices.push_back(index);
-        //         }
-        //         auto sub_mesh = in_mesh->sub_meshes.front();
-        //         sub_mesh.vertex_offset = vertex_offset;
-        //         sub_mesh.first_index = index_offset;
+            NOVA_LOG("Sanitised meshes:");
+            NOVA_LOG("  non-finite positions   = {}", stats.non_finite_positions);
+            NOVA_LOG("  invalid attributes     = {}", stats.invalid_attributes);
+            NOVA_LOG("  out of range triangles = {}", stats.out_of_range_triangles);
+            NOVA_LOG("  degenerate triangles   = {}", stats.degenerate_triangles);
+            NOVA_LOG("  duplicate triangles    = {}", stats.duplicate_triangles);
+            NOVA_LOG("  trimmed vertices       = {}", stats.trimmed_vertices);
+        }
 
-        //         joined_mesh->sub_meshes.push_back(sub_mesh);
-        //     }
+        {
+            MeshStats stats;
+            u32 compiled_count = 0;
+            u32 cached_count = 0;
+            for (auto& s : mesh_stats) {
+                compiled_count += s.output_meshes > 0;
+                cached_count += s.cached;
+                stats.source_vertices += s.source_vertices;
+                stats.welded_vertices += s.welded_vertices;
+                stats.split_meshes += s.split_meshes;
+                stats.output_meshes += s.output_meshes;
+                stats.quantise_vertices += s.quantise_vertices;
+                stats.quantised_vertices += s.quantised_vertices;
+                stats.quantisation_error = std::max(stats.quantisation_error, s.quantisation_error);
+                stats.indices += s.indices;
+                stats.indices_u16 += s.indices_u16;
+            }
 
-        //     auto out_instance = Ref<TriMeshInstance>::Create();
-        //     out_instance->mesh = joined_mesh;
-        //     out_instance->transform = Mat4(1.f);
+            auto Percent = [](u64 part, u64 total) {
+                return (100.0 * part) / std::max(u64(1), total);
+            };
 
-        //     out_scene.instances.clear();
-        //     out_scene.meshes.clear();
+            NOVA_LOG("Compiled meshes: {} ({} cached)", compiled_count, cached_count);
+            if (weld_vertices) {
+                NOVA_LOG("Welded unique vertices: {} -> {} ({:.2f}%)", stats.source_vertices, stats.welded_vertices,
+                    Percent(stats.welded_vertices, stats.source_vertices));
+            }
+            if (split_triangle_threshold) {
+                NOVA_LOG("Split {} meshes into {} chunks", stats.split_meshes, stats.output_meshes - (compiled_count - stats.split_meshes));
+            }
+            if (quantise_positions) {
+#ifdef AXIOM_TRACE_COMPILE // --------------------------------------------------
+                for (u32 i = mesh_offset; i < out_scene.meshes.size(); ++i) {
+                    NOVA_LOG("Mesh[{}] position quantisation error = {}", i, out_scene.meshes[i].quantisation_error);
+                }
+#endif // ----------------------------------------------------------------------
+                NOVA_LOG("Quantised positions, max error = {}", stats.quantisation_error);
+                if (weld_vertices) {
+                    NOVA_LOG("Welded quantised vertices: {} -> {} ({:.2f}%)", stats.quantise_vertices, stats.quantised_vertices,
+                        Percent(stats.quantised_vertices, stats.quantise_vertices));
+                }
+            }
+            if (compact_indices) {
+                NOVA_LOG("16-bit indices: {} / {} ({:.2f}%)", stats.indices_u16, stats.indices + stats.indices_u16,
+                    Percent(stats.indices_u16, stats.indices + stats.indices_u16));
+            }
+        }
+
+        // Source nodes become transform hierarchy nodes, so that instances can be moved
+        // after compilation. Flattened instances have no node and remain static
+
+        std::vector<u32> node_ids(in_scene.nodes.size());
+        for (u32 i = 0; i < in_scene.nodes.size(); ++i) {
+            auto& in_node = in_scene.nodes[i];
+            node_ids[i] = out_scene.transforms.Add(in_node.parent == scene_ir::InvalidIndex
+                ? TransformHierarchy::InvalidNode
+                : node_ids[in_node.parent], in_node.transform);
+        }
+
+        auto AddInstance = [&](const MeshRemap& remap, const Mat4& transform, u32 node_idx) {
+            u32 node = TransformHierarchy::InvalidNode;
+            if (node_idx != scene_ir::InvalidIndex) {
+                node = node_ids[node_idx];
+
+                // Rigid match transforms are attached as a leaf, keeping instance
+                // transforms equal to the world transform of their node
+                if (remap.transform != Mat4(1.f)) {
+                    node = out_scene.transforms.Add(node, Mat4x3(remap.transform));
+                }
+            }
+
+            for (auto mesh : remap.meshes) {
+                auto& out_instance = out_scene.instances.emplace_back();
+                out_instance.mesh = mesh;
+                out_instance.transform = Mat4x3(transform * remap.transform);
+                out_instance.node = node;
+                ComputeWorldBounds(out_scene.Get(mesh), out_instance);
+            }
+        };
+
+        // Merged meshes are shared between all instances of the same parts
+
+        struct MergedGroup
+        {
+            std::vector<Index<TriMesh>> parts;
+            MeshRemap                   remap;
+        };
+
+        nova::HashMap<u64, std::vector<MergedGroup>> merged_groups;
+        std::vector<Index<TriMesh>> parts;
+
+        u32 instance_offset = u32(out_scene.instances.size());
+        u64 part_instance_count = 0;
+
+        for (auto& in_instance : instances) {
+            part_instance_count += in_instance.mesh_count;
+
+            // Parts can only be merged when they share a transform and position format,
+            // split meshes are kept as separate instances
+
+            bool mergeable = merge_primitives && in_instance.mesh_count > 1;
+            auto& first = mesh_remap[in_instance.mesh_idx];
+            for (u32 i = 0; mergeable && i < in_instance.mesh_count; ++i) {
+                auto& remap = mesh_remap[in_instance.mesh_idx + i];
+                mergeable = remap.meshes.size() == 1
+                    && std::memcmp(&remap.transform, &first.transform, sizeof(Mat4)) == 0
+                    && out_scene.Get(remap.meshes[0]).IsQuantised() == out_scene.Get(first.meshes[0]).IsQuantised();
+            }
+
+            if (!mergeable) {
+                for (u32 i = 0; i < in_instance.mesh_count; ++i) {
+                    AddInstance(mesh_remap[in_instance.mesh_idx + i], Mat4(in_instance.transform), in_instance.node_idx);
+                }
+                continue;
+            }
+
+            parts.clear();
+            for (u32 i = 0; i < in_instance.mesh_count; ++i) {
+                parts.push_back(mesh_remap[in_instance.mesh_idx + i].meshes[0]);
+            }
+
+            auto& bucket = merged_groups[HashContents(parts)];
+            auto group = std::ranges::find_if(bucket, [&](auto& g) { return g.parts == parts; });
+            if (group == bucket.end()) {
+                auto merged = MergeMeshes(out_scene, parts);
+                bucket.push_back({ parts, { { out_scene.meshes.size() }, first.transform } });
+                out_scene.meshes.push_back(std::move(merged));
+                group = bucket.end() - 1;
+            }
+
+            AddInstance(group->remap, Mat4(in_instance.transform), in_instance.node_idx);
+        }
+
+        NOVA_LOG("Instances: {} -> {}", part_instance_count, out_scene.instances.size() - instance_offset);
+
+#ifdef AXIOM_TRACE_COMPILE // --------------------------------------------------
+        {
+            // Checks how many instances survive packing to TRS for streaming. Errors
+            // are relative to the largest axis scale of each transform
+
+            u32 representable = 0;
+            f32 max_error = 0.f;
+            for (u32 i = instance_offset; i < out_scene.instances.size(); ++i) {
+                auto& transform = out_scene.instances[i].transform;
+                auto unpacked = UnpackTRS(PackTRS(transform));
+
+                f32 scale = std::max({ glm::length(transform[0]), glm::length(transform[1]), glm::length(transform[2]), FLT_MIN });
+                f32 error = 0.f;
+                for (u32 c = 0; c < 3; ++c) {
+                    Vec3 delta = glm::abs(unpacked[c] - transform[c]) / scale;
+                    error = std::max({ error, delta.x, delta.y, delta.z });
+                }
+
+                if (error < 1e-3f) {
+                    representable++;
+                    max_error = std::max(max_error, error);
+                }
+            }
+            u32 count = out_scene.instances.size() - instance_offset;
+            NOVA_LOG("Instance transforms as TRS: {} / {}, max error = {} ({} -> {} bytes)", representable, count, max_error,
+                count * sizeof(Mat4x3), count * sizeof(PackedTRS));
+        }
+#endif // ----------------------------------------------------------------------
+
+        // Rebuild the mesh list from the meshes that are still referenced, dropping
+        // parts that only exist within merged meshes
+
+        {
+            std::vector<u32> new_index(out_scene.meshes.size() - mesh_offset, UINT32_MAX);
+            std::vector<TriMesh> meshes;
+            for (u32 i = instance_offset; i < out_scene.instances.size(); ++i) {
+                auto& mesh = out_scene.instances[i].mesh;
+                u32& index = new_index[mesh.value - mesh_offset];
+                if (index == UINT32_MAX) {
+                    index = mesh_offset + u32(meshes.size());
+                    meshes.push_back(std::move(out_scene.Get(mesh)));
+                }
+                mesh = index;
+            }
+            out_scene.meshes.resize(mesh_offset);
+            std::ranges::move(meshes, std::back_inserter(out_scene.meshes));
+        }
+
+        out_scene.UpdateTransforms();
+    }
+
+    void SceneCompiler::CompileMesh(scene_ir::Mesh& in_mesh, bool consume, std::vector<TriMesh>& out_meshes, MeshStats& stats)
+    {
+        TriMesh mesh;
+
+        if (consume) {
+            mesh.position_attributes = std::move(in_mesh.positions);
+            mesh.indices = std::move(in_mesh.indices);
+        } else {
+            mesh.position_attributes.assign(in_mesh.positions.begin(), in_mesh.positions.end());
+            mesh.indices.assign(in_mesh.indices.begin(), in_mesh.indices.end());
+        }
+
+        usz vertex_count = mesh.position_attributes.size();
+        usz index_count = mesh.indices.size();
+
+        mesh.shading_attributes.resize(vertex_count);
+
+        S_MeshProcessor.flip_uvs = flip_uvs;
+        S_MeshProcessor.ProcessMesh(
+            { &mesh.position_attributes[0], sizeof(mesh.position_attributes[0]), vertex_count },
+            !in_mesh.normals.empty()
+                ? InStridedRegion{ &in_mesh.normals[0], sizeof(in_mesh.normals[0]), vertex_count }
+                : InStridedRegion{},
+            !in_mesh.tex_coords.empty()
+                ? InStridedRegion{ &in_mesh.tex_coords[0], sizeof(in_mesh.tex_coords[0]), vertex_count }
+                : InStridedRegion{},
+            { &mesh.indices[0], sizeof(mesh.indices[0]), index_count },
+            { &mesh.shading_attributes[0].tangent_space, sizeof(mesh.shading_attributes[0]), vertex_count },
+            { &mesh.shading_attributes[0].tex_coords, sizeof(mesh.shading_attributes[0]), vertex_count });
+
+        mesh.sub_meshes.push_back(TriSubMesh {
+            .vertex_offset = 0,
+            .max_vertex = u32(vertex_count - 1),
+            .first_index = 0,
+            .index_count = u32(index_count),
+        });
+
+        stats.source_vertices = vertex_count;
+        if (weld_vertices) {
+            WeldVertices(mesh);
+        }
+        stats.welded_vertices = mesh.GetVertexCount();
+
+        ComputeBounds(mesh);
+
+        if (split_triangle_threshold) {
+            SplitMesh(mesh, out_meshes);
+            stats.split_meshes = !out_meshes.empty();
+        }
+        if (out_meshes.empty()) {
+            out_meshes.push_back(std::move(mesh));
+        }
+        stats.output_meshes = u32(out_meshes.size());
+
+        for (auto& out_mesh : out_meshes) {
+            if (reorder_triangles) {
+                ReorderTriangles(out_mesh);
+            }
+
+            if (lod_levels) {
+                GenerateLods(out_mesh);
+            }
+
+            if (quantise_positions) {
+                stats.quantise_vertices += out_mesh.GetVertexCount();
+                QuantisePositions(out_mesh);
+                stats.quantisation_error = std::max(stats.quantisation_error, out_mesh.quantisation_error);
+
+                // Quantisation can map neighbouring vertices to the same position
+                if (weld_vertices) {
+                    WeldVertices(out_mesh);
+                }
+                stats.quantised_vertices += out_mesh.GetVertexCount();
+            }
+
+            if (compact_indices) {
+                PackIndices(out_mesh);
+            }
+
+            stats.indices += out_mesh.indices.size();
+            stats.indices_u16 += out_mesh.indices_u16.size();
+        }
+    }
+
+    void SceneCompiler::SanitiseMesh(scene_ir::Mesh& mesh, SanitiseStats& stats)
+    {
+        u32 vertex_count = u32(mesh.positions.size());
+
+        auto IsFinite = [](const auto& v) {
+            for (usz i = 0; i < sizeof(v) / sizeof(f32); ++i) {
+                if (!std::isfinite(v[i])) {
+                    return false;
+                }
+            }
+            return true;
+        };
+
+        // Non-finite positions are zeroed, and triangles using them dropped below
+
+        std::vector<u8> invalid_vertex(vertex_count, 0);
+        for (u32 i = 0; i < vertex_count; ++i) {
+            if (!IsFinite(mesh.positions[i])) {
+                mesh.positions[i] = Vec3(0.f);
+                invalid_vertex[i] = 1;
+                stats.non_finite_positions++;
+            }
+        }
+
+        // Attributes that don't match the vertex count or contain invalid values are
+        // discarded or reset. Normals are regenerated by ProcessMesh when missing
+
+        if (!mesh.normals.empty()) {
+            bool valid = mesh.normals.size() == vertex_count;
+            for (u32 i = 0; valid && i < vertex_count; ++i) {
+                valid = IsFinite(mesh.normals[i]) && glm::dot(mesh.normals[i], mesh.normals[i]) > 0.f;
+            }
+            if (!valid) {
+                mesh.normals.clear();
+                stats.invalid_attributes++;
+            }
+        }
+
+        if (!mesh.tex_coords.empty()) {
+            if (mesh.tex_coords.size() != vertex_count) {
+                mesh.tex_coords.clear();
+                stats.invalid_attributes++;
+            } else {
+                for (auto& tex_coord : mesh.tex_coords) {
+                    if (!IsFinite(tex_coord)) {
+                        tex_coord = Vec2(0.f);
+                        stats.invalid_attributes++;
+                    }
+                }
+            }
+        }
+
+        // Filter triangles
+
+        if (mesh.indices.size() % 3) {
+            mesh.indices.resize(mesh.indices.size() - mesh.indices.size() % 3);
+            stats.out_of_range_triangles++;
+        }
+
+        ankerl::unordered_dense::set<TriangleIndicesKey> unique_triangles;
+
+        u32 max_vertex = 0;
+        u32 write = 0;
+        for (u32 i = 0; i < mesh.indices.size(); i += 3) {
+            u32 a = mesh.indices[i + 0];
+            u32 b = mesh.indices[i + 1];
+            u32 c = mesh.indices[i + 2];
+
+            if (a >= vertex_count || b >= vertex_count || c >= vertex_count
+                    || invalid_vertex[a] || invalid_vertex[b] || invalid_vertex[c]) {
+                stats.out_of_range_triangles++;
+                continue;
+            }
+
+            Vec3 cross = glm::cross(mesh.positions[b] - mesh.positions[a], mesh.positions[c] - mesh.positions[a]);
+            if (a == b || b == c || c == a || glm::dot(cross, cross) == 0.f) {
+                stats.degenerate_triangles++;
+                continue;
+            }
+
+            // Rotate to the smallest index first, keeping winding so that
+            // intentionally double sided geometry is preserved
+            TriangleIndicesKey key;
+            if (a < b && a < c) {
+                key = {{ a, b, c }};
+            } else if (b < c) {
+                key = {{ b, c, a }};
+            } else {
+                key = {{ c, a, b }};
+            }
+            if (!unique_triangles.insert(key).second) {
+                stats.duplicate_triangles++;
+                continue;
+            }
+
+            mesh.indices[write++] = a;
+            mesh.indices[write++] = b;
+            mesh.indices[write++] = c;
+            max_vertex = std::max({ max_vertex, a, b, c });
+        }
+        mesh.indices.resize(write);
+
+        // Trim unreferenced trailing vertices
+
+        u32 used_vertex_count = write ? max_vertex + 1 : 0;
+        if (used_vertex_count < vertex_count) {
+            stats.trimmed_vertices += vertex_count - used_vertex_count;
+            mesh.positions.resize(used_vertex_count);
+            if (!mesh.normals.empty()) mesh.normals.resize(used_vertex_count);
+            if (!mesh.tex_coords.empty()) mesh.tex_coords.resize(used_vertex_count);
+        }
+    }
+
+    void SceneCompiler::FindRigidMatches(std::span<const scene_ir::Mesh* const> meshes, const std::vector<u32>& canonical_materials,
+        const std::vector<u8>& referenced, std::vector<RigidMatch>& matches)
+    {
+        // Similarity frame of a mesh, derived from its centroid and two well spread
+        // vertices. Copies related by rotation, uniform scale and translation produce
+        // frames related by the same transform when built from the same vertices,
+        // which holds as matches require identical vertex ordering
+
+        struct MeshFrame
+        {
+            u64      key = 0;
+            Vec3  centroid;
+            u32      first = 0;
+            u32     second = 0;
+            f32     radius = 0.f;
+            bool     valid = false;
+        };
+
+        auto GetBasis = [](const scene_ir::Mesh& mesh, const MeshFrame& frame, const MeshFrame& reference) {
+            Vec3 axis = mesh.positions[reference.first] - frame.centroid;
+            Vec3 e0 = glm::normalize(axis);
+            Vec3 e2 = glm::normalize(glm::cross(axis, mesh.positions[reference.second] - frame.centroid));
+            return Mat3(e0, glm::cross(e2, e0), e2);
+        };
+
+        std::vector<MeshFrame> frames(meshes.size());
+
+#pragma omp parallel for
+        for (u32 i = 0; i < meshes.size(); ++i) {
+            auto& mesh = *meshes[i];
+            auto& frame = frames[i];
+
+            // Unreferenced meshes are not compiled, so must never become canonical
+            if (!referenced[i] || matches[i].canonical_idx != i || mesh.positions.size() < 3) {
+                continue;
+            }
+
+            frame.key = HashContents(std::vector<u64> {
+                HashContents(mesh.indices),
+                HashContents(mesh.tex_coords),
+                u64(mesh.positions.size()) << 32 | GetCanonicalMaterial(canonical_materials, mesh.material_idx),
+            });
+
+            f64 count = f64(mesh.positions.size());
+            glm::dvec3 sum = {};
+            for (auto& position : mesh.positions) {
+                sum += glm::dvec3(position);
+            }
+            frame.centroid = Vec3(sum / count);
+
+            for (u32 j = 0; j < mesh.positions.size(); ++j) {
+                f32 radius = glm::distance(mesh.positions[j], frame.centroid);
+                if (radius > frame.radius) {
+                    frame.radius = radius;
+                    frame.first = j;
+                }
+            }
+
+            Vec3 axis = mesh.positions[frame.first] - frame.centroid;
+
+            f32 max_cross = 0.f;
+            for (u32 j = 0; j < mesh.positions.size(); ++j) {
+                f32 cross = glm::length(glm::cross(axis, mesh.positions[j] - frame.centroid));
+                if (cross > max_cross) {
+                    max_cross = cross;
+                    frame.second = j;
+                }
+            }
+
+            // Reject (near) collinear meshes, rotation about the line is unrecoverable
+            frame.valid = max_cross > 1e-3f * frame.radius * frame.radius;
+        }
+
+        auto TryMatch = [&](u32 canonical_idx, u32 idx, Mat4& transform) {
+            auto& canonical = *meshes[canonical_idx];
+            auto& mesh = *meshes[idx];
+            auto& from = frames[canonical_idx];
+            auto& to = frames[idx];
+
+            if (!SameContents(canonical.indices, mesh.indices)
+                    || !SameContents(canonical.tex_coords, mesh.tex_coords)
+                    || canonical.normals.size() != mesh.normals.size()) {
+                return false;
+            }
+
+            f32 from_length = glm::distance(canonical.positions[from.first], from.centroid);
+            f32 to_length = glm::distance(mesh.positions[from.first], to.centroid);
+            if (to_length == 0.f) {
+                return false;
+            }
+
+            Mat3 rotation = GetBasis(mesh, to, from) * glm::transpose(GetBasis(canonical, from, from));
+            f32 scale = to_length / from_length;
+            Vec3 translation = to.centroid - scale * (rotation * from.centroid);
+
+            // Comparisons are written to also reject NaNs from degenerate bases
+
+            f32 tolerance = rigid_match_tolerance * to.radius;
+            for (u32 i = 0; i < mesh.positions.size(); ++i) {
+                Vec3 p = scale * (rotation * canonical.positions[i]) + translation;
+                if (!(glm::distance(p, mesh.positions[i]) <= tolerance)) {
+                    return false;
+                }
+            }
+
+            // Shading normals must rotate with the geometry
+            for (u32 i = 0; i < mesh.normals.size(); ++i) {
+                Vec3 a = rotation * canonical.normals[i];
+                Vec3 b = mesh.normals[i];
+                if (!(glm::dot(a, b) >= 0.999f * glm::length(a) * glm::length(b))) {
+                    return false;
+                }
+            }
+
+            transform = Mat4(scale * rotation);
+            transform[3] = Vec4(translation, 1.f);
+            return true;
+        };
+
+        // Only a limited number of distinct canonical meshes are tried per key
+
+        constexpr u32 MaxCandidates = 8;
+
+        nova::HashMap<u64, std::vector<u32>> candidates;
+        u32 matched = 0;
+        for (u32 i = 0; i < meshes.size(); ++i) {
+            if (!frames[i].valid) {
+                continue;
+            }
+
+            auto& bucket = candidates[frames[i].key];
+            bool found = false;
+            for (u32 canonical_idx : bucket) {
+                if (TryMatch(canonical_idx, i, matches[i].transform)) {
+                    matches[i].canonical_idx = canonical_idx;
+                    found = true;
+                    matched++;
+                    break;
+                }
+            }
+
+            if (!found && bucket.size() < MaxCandidates) {
+                bucket.push_back(i);
+            }
+        }
+
+        NOVA_LOG("Rigid mesh matches: {} / {}", matched, meshes.size());
+    }
+
+    bool SceneCompiler::FlattenInstances(std::span<const scene_ir::Mesh* const> meshes, std::span<const scene_ir::Instance> instances,
+        const std::vector<u32>& canonical_materials, std::vector<RigidMatch>& rigid_matches,
+        std::vector<scene_ir::Mesh>& out_meshes, std::vector<scene_ir::Instance>& out_instances)
+    {
+        // Count uses through rigid matches, as copies are instanced after compilation
+
+        std::vector<u32> uses(meshes.size());
+        for (auto& instance : instances) {
+            for (u32 i = 0; i < instance.mesh_count; ++i) {
+                uses[rigid_matches[instance.mesh_idx + i].canonical_idx]++;
+            }
+        }
+
+        struct Candidate
+        {
+            u32 instance_idx;
+            Vec3      center;
+            u32    triangles;
+            u32       morton = 0;
+        };
+
+        // Meshes are not sanitised when sanitise_meshes is unset. Meshes that could misalign
+        // a batch or produce a non-finite center are left to be compiled on their own
+
+        auto IsFinite = [](Vec3 v) {
+            return std::isfinite(v.x) && std::isfinite(v.y) && std::isfinite(v.z);
+        };
+
+        auto CanFlatten = [&](const scene_ir::Mesh& mesh) {
+            if (mesh.indices.size() % 3) {
+                return false;
+            }
+            for (u32 index : mesh.indices) {
+                if (index >= mesh.positions.size()) {
+                    return false;
+                }
+            }
+            return std::ranges::all_of(mesh.positions, IsFinite);
+        };
+
+        std::vector<Candidate> candidates;
+        Vec3 scene_min = Vec3(FLT_MAX);
+        Vec3 scene_max = Vec3(-FLT_MAX);
+
+        for (u32 instance_idx = 0; instance_idx < instances.size(); ++instance_idx) {
+            auto& instance = instances[instance_idx];
+
+            bool flatten = true;
+            u32 triangles = 0;
+            Vec3 min = Vec3(FLT_MAX);
+            Vec3 max = Vec3(-FLT_MAX);
+            for (u32 i = 0; flatten && i < instance.mesh_count; ++i) {
+                auto& mesh = *meshes[instance.mesh_idx + i];
+                flatten = uses[rigid_matches[instance.mesh_idx + i].canonical_idx] == 1 && CanFlatten(mesh);
+                triangles += u32(mesh.indices.size() / 3);
+                for (auto& position : mesh.positions) {
+                    Vec3 world = instance.transform * Vec4(position, 1.f);
+                    min = glm::min(min, world);
+                    max = glm::max(max, world);
+                }
+            }
+
+            Vec3 center = 0.5f * (min + max);
+            if (!flatten || !triangles || !IsFinite(center)) {
+                continue;
+            }
+
+            candidates.push_back({ instance_idx, center, triangles });
+            scene_min = glm::min(scene_min, center);
+            scene_max = glm::max(scene_max, center);
+        }
+
+        if (candidates.size() < 2) {
+            return false;
+        }
+
+        // Order by Morton code so that consecutive runs are spatially coherent
+
+        Vec3 extent = glm::max(scene_max - scene_min, Vec3(1e-6f));
+        for (auto& candidate : candidates) {
+            candidate.morton = MortonCode((candidate.center - scene_min) / extent);
+        }
+        std::ranges::sort(candidates, {}, &Candidate::morton);
+
+        // Emit batches with one mesh per material and attribute layout, as a group
+        // that merge_primitives turns into a single multi sub mesh TriMesh
+
+        std::vector<u8> flattened(instances.size(), 0);
+        std::vector<scene_ir::Mesh> batch_meshes;
+        nova::HashMap<u64, u32> batch_mesh_indices;
+
+        for (u32 begin = 0; begin < candidates.size();) {
+            u32 end = begin;
+            u32 triangles = 0;
+            while (end < candidates.size() && triangles < flatten_target_triangles) {
+                triangles += candidates[end++].triangles;
+            }
+
+            batch_meshes.clear();
+            batch_mesh_indices.clear();
+
+            for (u32 c = begin; c < end; ++c) {
+                auto& instance = instances[candidates[c].instance_idx];
+                flattened[candidates[c].instance_idx] = 1;
+
+                Mat4 transform = Mat4(instance.transform);
+                Mat3 normal_transform = glm::transpose(glm::inverse(Mat3(transform)));
+                bool mirrored = glm::determinant(Mat3(transform)) < 0.f;
+
+                for (u32 i = 0; i < instance.mesh_count; ++i) {
+                    auto& in_mesh = *meshes[instance.mesh_idx + i];
+
+                    // Attributes that don't match the vertex count are dropped so that
+                    // they can't misalign the batch
+                    bool has_normals = !in_mesh.normals.empty() && in_mesh.normals.size() == in_mesh.positions.size();
+                    bool has_tex_coords = !in_mesh.tex_coords.empty() && in_mesh.tex_coords.size() == in_mesh.positions.size();
+                    u32 material_idx = GetCanonicalMaterial(canonical_materials, in_mesh.material_idx);
+                    u64 key = u64(material_idx) | u64(has_normals) << 32 | u64(has_tex_coords) << 33;
+
+                    auto[iter, inserted] = batch_mesh_indices.insert({ key, u32(batch_meshes.size()) });
+                    if (inserted) {
+                        batch_meshes.emplace_back().material_idx = material_idx;
+                    }
+                    auto& out_mesh = batch_meshes[iter->second];
+
+                    u32 vertex_offset = u32(out_mesh.positions.size());
+
+                    for (auto& position : in_mesh.positions) {
+                        out_mesh.positions.push_back(Vec3(transform * Vec4(position, 1.f)));
+                    }
+                    if (has_normals) {
+                        for (auto& normal : in_mesh.normals) {
+                            Vec3 world = normal_transform * normal;
+                            f32 length = glm::length(world);
+                            out_mesh.normals.push_back(length > 0.f ? world / length : world);
+                        }
+                    }
+                    if (has_tex_coords) {
+                        out_mesh.tex_coords.insert(out_mesh.tex_coords.end(), in_mesh.tex_coords.begin(), in_mesh.tex_coords.end());
+                    }
+
+                    // Mirroring transforms flip winding, swap to preserve facing
+                    for (u32 j = 0; j < in_mesh.indices.size(); j += 3) {
+                        out_mesh.indices.push_back(vertex_offset + in_mesh.indices[j + 0]);
+                        out_mesh.indices.push_back(vertex_offset + in_mesh.indices[j + (mirrored ? 2 : 1)]);
+                        out_mesh.indices.push_back(vertex_offset + in_mesh.indices[j + (mirrored ? 1 : 2)]);
+                    }
+                }
+            }
+
+            // Batch meshes are numbered after the scene's own meshes
+
+            u32 first_mesh = u32(meshes.size() + out_meshes.size());
+            out_instances.push_back(scene_ir::Instance {
+                .mesh_idx = first_mesh,
+                .mesh_count = u32(batch_meshes.size()),
+                .transform = Mat4x3(1.f),
+            });
+
+            for (auto& mesh : batch_meshes) {
+                rigid_matches.push_back({ u32(meshes.size() + out_meshes.size()), Mat4(1.f) });
+                out_meshes.push_back(std::move(mesh));
+            }
+
+            begin = end;
+        }
+
+        u32 batch_count = u32(out_instances.size());
+        for (u32 i = 0; i < instances.size(); ++i) {
+            if (!flattened[i]) {
+                out_instances.push_back(instances[i]);
+            }
+        }
+
+        NOVA_LOG("Flattened {} unique instances into {} batches", candidates.size(), batch_count);
+
+        return true;
+    }
+
+    void SceneCompiler::WeldVertices(TriMesh& mesh)
+    {
+        // Compacts in place, which relies on sub meshes owning disjoint vertex
+        // ranges in ascending order, as emitted by Compile. Must run before PackIndices
+
+        thread_local nova::HashMap<WeldKey, u32> unique_vertices;
+        thread_local std::vector<u32> remap;
+
+        bool quantised = mesh.IsQuantised();
+
+        u32 out_vertex = 0;
+        for (auto& sub_mesh : mesh.sub_meshes) {
+            unique_vertices.clear();
+            remap.resize(sub_mesh.max_vertex + 1);
+
+            u32 out_offset = out_vertex;
+            for (u32 i = 0; i <= sub_mesh.max_vertex; ++i) {
+                u32 vertex = sub_mesh.vertex_offset + i;
+
+                WeldKey key = {};
+                if (quantised) {
+                    auto& q = mesh.quantised_positions[vertex];
+                    key.position[0] = q.x;
+                    key.position[1] = q.y;
+                    key.position[2] = q.z;
+                } else {
+                    std::memcpy(key.position, &mesh.position_attributes[vertex], sizeof(Vec3));
+                }
+                key.shading = mesh.shading_attributes[vertex];
+
+                auto[iter, inserted] = unique_vertices.insert({ key, out_vertex - out_offset });
+                if (inserted) {
+                    if (quantised) {
+                        mesh.quantised_positions[out_vertex] = mesh.quantised_positions[vertex];
+                    } else {
+                        mesh.position_attributes[out_vertex] = mesh.position_attributes[vertex];
+                    }
+                    mesh.shading_attributes[out_vertex] = mesh.shading_attributes[vertex];
+                    out_vertex++;
+                }
+                remap[i] = iter->second;
+            }
+
+            auto Remap = [&](u32 first_index, u32 index_count) {
+                for (u32 i = 0; i < index_count; ++i) {
+                    auto& index = mesh.indices[first_index + i];
+                    index = remap[index];
+                }
+            };
+
+            Remap(sub_mesh.first_index, sub_mesh.index_count);
+            for (auto& lod : sub_mesh.lods) {
+                Remap(lod.first_index, lod.index_count);
+            }
+
+            sub_mesh.vertex_offset = out_offset;
+            sub_mesh.max_vertex = out_vertex - out_offset - 1;
+        }
+
+        if (quantised) {
+            mesh.quantised_positions.resize(out_vertex);
+        } else {
+            mesh.position_attributes.resize(out_vertex);
+        }
+        mesh.shading_attributes.resize(out_vertex);
+    }
+
+    void SceneCompiler::ReorderTriangles(TriMesh& mesh)
+    {
+        // Requires sub mesh bounds from ComputeBounds. Must run before PackIndices
+
+        struct TriangleKey
+        {
+            u32   morton;
+            u32 triangle;
+        };
+
+        thread_local std::vector<TriangleKey> keys;
+        thread_local std::vector<u32> sorted_indices;
+        thread_local std::vector<u32> remap;
+        thread_local std::vector<Vec3> positions;
+        thread_local std::vector<GPU_QuantisedPosition> quantised_positions;
+        thread_local std::vector<ShadingAttributes> shading_attributes;
+
+#ifdef AXIOM_TRACE_COMPILE // --------------------------------------------------
+        // Mean distance between consecutive triangle centroids, as a locality metric
+        f64 distance_before = 0.0;
+        f64 distance_after = 0.0;
+        u64 triangle_count = 0;
+#endif // ----------------------------------------------------------------------
+
+        for (auto& sub_mesh : mesh.sub_meshes) {
+            u32* indices = &mesh.indices[sub_mesh.first_index];
+            u32 vertex_count = sub_mesh.max_vertex + 1;
+
+            auto GetCentroid = [&](const u32* triangle) {
+                return (mesh.GetPosition(sub_mesh, triangle[0])
+                    + mesh.GetPosition(sub_mesh, triangle[1])
+                    + mesh.GetPosition(sub_mesh, triangle[2])) / 3.f;
+            };
+
+            // Sort triangles, ties keep their original order
+
+            Vec3 extent = glm::max(sub_mesh.bounds_max - sub_mesh.bounds_min, Vec3(1e-6f));
+
+            keys.clear();
+            for (u32 i = 0; i < sub_mesh.index_count; i += 3) {
+                keys.push_back({ MortonCode((GetCentroid(indices + i) - sub_mesh.bounds_min) / extent), i / 3 });
+            }
+            std::ranges::sort(keys, [](auto& l, auto& r) {
+                return l.morton != r.morton ? l.morton < r.morton : l.triangle < r.triangle;
+            });
+
+            sorted_indices.clear();
+            for (auto& key : keys) {
+                sorted_indices.push_back(indices[key.triangle * 3 + 0]);
+                sorted_indices.push_back(indices[key.triangle * 3 + 1]);
+                sorted_indices.push_back(indices[key.triangle * 3 + 2]);
+            }
+
+#ifdef AXIOM_TRACE_COMPILE // --------------------------------------------------
+            for (u32 i = 3; i < sub_mesh.index_count; i += 3) {
+                distance_before += glm::distance(GetCentroid(indices + i - 3), GetCentroid(indices + i));
+                distance_after += glm::distance(GetCentroid(&sorted_indices[i - 3]), GetCentroid(&sorted_indices[i]));
+            }
+            triangle_count += sub_mesh.index_count / 3;
+#endif // ----------------------------------------------------------------------
+
+            std::copy(sorted_indices.begin(), sorted_indices.end(), indices);
+
+            // Renumber vertices by first use, unused vertices are kept at the end
+
+            constexpr u32 Unassigned = UINT32_MAX;
+
+            remap.assign(vertex_count, Unassigned);
+            u32 next_vertex = 0;
+            for (u32 i = 0; i < sub_mesh.index_count; ++i) {
+                if (remap[indices[i]] == Unassigned) {
+                    remap[indices[i]] = next_vertex++;
+                }
+            }
+            for (auto& target : remap) {
+                if (target == Unassigned) {
+                    target = next_vertex++;
+                }
+            }
+
+            auto Permute = [&](auto& attributes, auto& scratch) {
+                if (attributes.empty()) {
+                    return;
+                }
+                scratch.resize(vertex_count);
+                for (u32 i = 0; i < vertex_count; ++i) {
+                    scratch[remap[i]] = attributes[sub_mesh.vertex_offset + i];
+                }
+                std::copy(scratch.begin(), scratch.end(), attributes.begin() + sub_mesh.vertex_offset);
+            };
+
+            Permute(mesh.position_attributes, positions);
+            Permute(mesh.quantised_positions, quantised_positions);
+            Permute(mesh.shading_attributes, shading_attributes);
+
+            auto Remap = [&](u32 first_index, u32 index_count) {
+                for (u32 i = 0; i < index_count; ++i) {
+                    auto& index = mesh.indices[first_index + i];
+                    index = remap[index];
+                }
+            };
+
+            Remap(sub_mesh.first_index, sub_mesh.index_count);
+            for (auto& lod : sub_mesh.lods) {
+                Remap(lod.first_index, lod.index_count);
+            }
+        }
+
+#ifdef AXIOM_TRACE_COMPILE // --------------------------------------------------
+        if (triangle_count > 1) {
+            NOVA_LOG("Reordered {} triangles, mean centroid step {} -> {}", triangle_count,
+                distance_before / f64(triangle_count - 1), distance_after / f64(triangle_count - 1));
+        }
+#endif // ----------------------------------------------------------------------
+    }
+
+    void SceneCompiler::SplitMesh(const TriMesh& mesh, std::vector<TriMesh>& chunks)
+    {
+        // Requires float positions, runs before LOD generation and index packing
+
+        bool oversized = false;
+        for (auto& sub_mesh : mesh.sub_meshes) {
+            oversized |= sub_mesh.index_count / 3 > split_triangle_threshold;
+        }
+        if (!oversized) {
+            return;
+        }
+
+        std::vector<Vec3> centroids;
+        std::vector<u32> triangles;
+        std::vector<std::pair<u32, u32>> leaves;
+        std::vector<u32> remap;
+
+        for (auto& sub_mesh : mesh.sub_meshes) {
+            const u32* indices = &mesh.indices[sub_mesh.first_index];
+            u32 triangle_count = sub_mesh.index_count / 3;
+
+            centroids.resize(triangle_count);
+            triangles.resize(triangle_count);
+            for (u32 i = 0; i < triangle_count; ++i) {
+                centroids[i] = (mesh.GetPosition(sub_mesh, indices[i * 3 + 0])
+                    + mesh.GetPosition(sub_mesh, indices[i * 3 + 1])
+                    + mesh.GetPosition(sub_mesh, indices[i * 3 + 2])) / 3.f;
+                triangles[i] = i;
+            }
+
+            // Recursive median split on the longest centroid axis
+
+            leaves.clear();
+            std::vector<std::pair<u32, u32>> stack { { 0, triangle_count } };
+            while (!stack.empty()) {
+                auto[begin, end] = stack.back();
+                stack.pop_back();
+
+                if (end - begin <= split_triangle_threshold) {
+                    leaves.push_back({ begin, end });
+                    continue;
+                }
+
+                Vec3 min = Vec3(FLT_MAX);
+                Vec3 max = Vec3(-FLT_MAX);
+                for (u32 i = begin; i < end; ++i) {
+                    min = glm::min(min, centroids[triangles[i]]);
+                    max = glm::max(max, centroids[triangles[i]]);
+                }
+                Vec3 extent = max - min;
+                u32 axis = extent.x > extent.y
+                    ? (extent.x > extent.z ? 0 : 2)
+                    : (extent.y > extent.z ? 1 : 2);
+
+                u32 middle = begin + (end - begin) / 2;
+                std::nth_element(triangles.begin() + begin, triangles.begin() + middle, triangles.begin() + end,
+                    [&](u32 l, u32 r) { return centroids[l][axis] < centroids[r][axis]; });
+
+                stack.push_back({ middle, end });
+                stack.push_back({ begin, middle });
+            }
+
+            // Emit each leaf as its own mesh, copying only the vertices it references
+
+            remap.assign(sub_mesh.max_vertex + 1, UINT32_MAX);
+            for (auto[begin, end] : leaves) {
+                auto& chunk = chunks.emplace_back();
+
+                for (u32 i = begin; i < end; ++i) {
+                    for (u32 j = 0; j < 3; ++j) {
+                        u32 index = indices[triangles[i] * 3 + j];
+                        if (remap[index] == UINT32_MAX) {
+                            remap[index] = u32(chunk.shading_attributes.size());
+                            chunk.position_attributes.push_back(mesh.GetPosition(sub_mesh, index));
+                            chunk.shading_attributes.push_back(mesh.shading_attributes[sub_mesh.vertex_offset + index]);
+                        }
+                        chunk.indices.push_back(remap[index]);
+                    }
+                }
+
+                for (u32 i = begin; i < end; ++i) {
+                    for (u32 j = 0; j < 3; ++j) {
+                        remap[indices[triangles[i] * 3 + j]] = UINT32_MAX;
+                    }
+                }
+
+                chunk.sub_meshes.push_back(TriSubMesh {
+                    .vertex_offset = 0,
+                    .max_vertex = u32(chunk.shading_attributes.size() - 1),
+                    .first_index = 0,
+                    .index_count = u32(chunk.indices.size()),
+                    .material = sub_mesh.material,
+                });
+
+                ComputeBounds(chunk);
+            }
+        }
+    }
+
+    void SceneCompiler::GenerateLods(TriMesh& mesh)
+    {
+        // Requires bounding spheres from ComputeBounds
+
+        std::vector<u32> source_indices;
+        std::vector<u32> lod_indices;
+
+        for (auto& sub_mesh : mesh.sub_meshes) {
+            nova::Span<const Vec3> positions{ &mesh.position_attributes[sub_mesh.vertex_offset], sub_mesh.max_vertex + 1 };
+
+            // Simplify each level from the previous one, accumulating error
+
+            source_indices.assign(
+                mesh.indices.begin() + sub_mesh.first_index,
+                mesh.indices.begin() + sub_mesh.first_index + sub_mesh.index_count);
+
+            f32 max_error = lod_max_error * sub_mesh.bounding_radius;
+            f32 error = 0.f;
+
+            for (u32 level = 0; level < lod_levels; ++level) {
+                u32 target_index_count = u32(f32(source_indices.size() / 3) * lod_target_ratio) * 3;
+                if (target_index_count < 3) {
+                    break;
+                }
+
+                f32 lod_error = S_MeshSimplifier.Simplify(positions, source_indices, target_index_count, max_error - error, lod_indices);
+
+                // Stop once simplification is no longer making meaningful progress
+                if (lod_indices.empty() || lod_indices.size() * 20 > source_indices.size() * 19) {
+                    break;
+                }
+
+                error += lod_error;
+
+                sub_mesh.lods.push_back(TriSubMeshLod {
+                    .first_index = u32(mesh.indices.size()),
+                    .index_count = u32(lod_indices.size()),
+                    .error = error,
+                });
+                mesh.indices.insert(mesh.indices.end(), lod_indices.begin(), lod_indices.end());
+
+                std::swap(source_indices, lod_indices);
+            }
+        }
+    }
+
+    void SceneCompiler::PackIndices(TriMesh& mesh)
+    {
+        // 0xFFFF is reserved as the primitive restart value
+        auto GetIndexType = [](const TriSubMesh& sub_mesh) {
+            return sub_mesh.max_vertex < 0xFFFF
+                ? nova::IndexType::U16
+                : nova::IndexType::U32;
+        };
+
+        usz count = 0;
+        usz count_u16 = 0;
+        for (auto& sub_mesh : mesh.sub_meshes) {
+            usz sub_mesh_count = sub_mesh.index_count;
+            for (auto& lod : sub_mesh.lods) {
+                sub_mesh_count += lod.index_count;
+            }
+            (GetIndexType(sub_mesh) == nova::IndexType::U16 ? count_u16 : count) += sub_mesh_count;
+        }
+
+        std::vector<u32> indices;
+        std::vector<u16> indices_u16;
+        indices.reserve(count);
+        indices_u16.reserve(count_u16);
+
+        auto Pack = [&](const TriSubMesh& sub_mesh, u32& first_index, u32 index_count) {
+            u32 source = first_index;
+            auto type = sub_mesh.index_type;
+
+            // Index types are chosen from max_vertex, so it must bound every index
+            for (u32 i = 0; i < index_count; ++i) {
+                if (mesh.indices[source + i] > sub_mesh.max_vertex) {
+                    NOVA_THROW("Index[{}] = {} exceeds max vertex {}", source + i, mesh.indices[source + i], sub_mesh.max_vertex);
+                }
+            }
+
+            if (type == nova::IndexType::U16) {
+                first_index = u32(indices_u16.size());
+                for (u32 i = 0; i < index_count; ++i) {
+                    indices_u16.push_back(u16(mesh.indices[source + i]));
+                }
+            } else {
+                first_index = u32(indices.size());
+                indices.insert(indices.end(),
+                    mesh.indices.begin() + source,
+                    mesh.indices.begin() + source + index_count);
+            }
+
+            // Validate round trip
+            for (u32 i = 0; i < index_count; ++i) {
+                u32 packed = type == nova::IndexType::U16
+                    ? u32(indices_u16[first_index + i])
+                    : indices[first_index + i];
+                if (packed != mesh.indices[source + i]) {
+                    NOVA_THROW("Index[{}] failed round trip, {} != {}", source + i, packed, mesh.indices[source + i]);
+                }
+            }
+        };
+
+        for (auto& sub_mesh : mesh.sub_meshes) {
+            sub_mesh.index_type = GetIndexType(sub_mesh);
+            Pack(sub_mesh, sub_mesh.first_index, sub_mesh.index_count);
+            for (auto& lod : sub_mesh.lods) {
+                Pack(sub_mesh, lod.first_index, lod.index_count);
+            }
+        }
+
+        mesh.indices = std::move(indices);
+        mesh.indices_u16 = std::move(indices_u16);
+    }
+
+    void SceneCompiler::QuantisePositions(TriMesh& mesh)
+    {
+        // Assumes sub meshes own disjoint vertex ranges, as emitted by Compile
+
+        mesh.quantised_positions.resize(mesh.position_attributes.size());
+        mesh.quantisation_error = 0.f;
+
+        for (auto& sub_mesh : mesh.sub_meshes) {
+            Vec3 min = mesh.position_attributes[sub_mesh.vertex_offset];
+            Vec3 max = min;
+            for (u32 i = 1; i <= sub_mesh.max_vertex; ++i) {
+                auto& position = mesh.position_attributes[sub_mesh.vertex_offset + i];
+                min = glm::min(min, position);
+                max = glm::max(max, position);
+            }
+
+            constexpr f32 MaxValue = f32(UINT16_MAX);
+
+            Vec3 extent = max - min;
+            sub_mesh.dequant_offset = min;
+            sub_mesh.dequant_scale = Vec3(
+                extent.x > 0.f ? extent.x / MaxValue : 1.f,
+                extent.y > 0.f ? extent.y / MaxValue : 1.f,
+                extent.z > 0.f ? extent.z / MaxValue : 1.f);
+
+            for (u32 i = 0; i <= sub_mesh.max_vertex; ++i) {
+                auto& position = mesh.position_attributes[sub_mesh.vertex_offset + i];
+                Vec3 q = glm::clamp(glm::round((position - min) / sub_mesh.dequant_scale), 0.f, MaxValue);
+                mesh.quantised_positions[sub_mesh.vertex_offset + i] = { u16(q.x), u16(q.y), u16(q.z) };
+
+                Vec3 decoded = mesh.GetPosition(sub_mesh, i);
+                mesh.quantisation_error = std::max(mesh.quantisation_error, glm::distance(decoded, position));
+            }
+        }
+
+        mesh.position_attributes.clear();
+        mesh.position_attributes.shrink_to_fit();
+    }
+
+    TriMesh SceneCompiler::MergeMeshes(const CompiledScene& scene, const std::vector<Index<TriMesh>>& parts)
+    {
+        TriMesh merged;
+        merged.bounds_min = Vec3(FLT_MAX);
+        merged.bounds_max = Vec3(-FLT_MAX);
+
+        for (auto part_idx : parts) {
+            auto& part = scene.Get(part_idx);
+            u32 vertex_offset = u32(merged.GetVertexCount());
+            u32 index_offset = u32(merged.indices.size());
+            u32 index_u16_offset = u32(merged.indices_u16.size());
+
+            auto Append = [](auto& target, auto& source) {
+                target.insert(target.end(), source.begin(), source.end());
+            };
+
+            Append(merged.position_attributes, part.position_attributes);
+            Append(merged.quantised_positions, part.quantised_positions);
+            Append(merged.shading_attributes, part.shading_attributes);
+            Append(merged.indices, part.indices);
+            Append(merged.indices_u16, part.indices_u16);
+
+            // Sub mesh indices are relative to vertex_offset, so only ranges need to move
+
+            for (auto sub_mesh : part.sub_meshes) {
+                u32 offset = sub_mesh.index_type == nova::IndexType::U16
+                    ? index_u16_offset
+                    : index_offset;
+
+                sub_mesh.vertex_offset += vertex_offset;
+                sub_mesh.first_index += offset;
+                for (auto& lod : sub_mesh.lods) {
+                    lod.first_index += offset;
+                }
+
+                merged.sub_meshes.push_back(std::move(sub_mesh));
+            }
+
+            merged.quantisation_error = std::max(merged.quantisation_error, part.quantisation_error);
+            merged.bounds_min = glm::min(merged.bounds_min, part.bounds_min);
+            merged.bounds_max = glm::max(merged.bounds_max, part.bounds_max);
+        }
+
+        return merged;
+    }
+
+    void SceneCompiler::DeduplicateMeshes(std::span<const scene_ir::Mesh* const> meshes, const std::vector<u32>& canonical_materials,
+        const std::vector<u8>& referenced, std::vector<RigidMatch>& matches)
+    {
+        // Source meshes are compared before compilation, compiled results are
+        // deterministic given the same contents and options
+
+        std::vector<u64> hashes(meshes.size());
+#pragma omp parallel for
+        for (u32 i = 0; i < meshes.size(); ++i) {
+            auto& mesh = *meshes[i];
+            if (!referenced[i]) {
+                continue;
+            }
+
+            hashes[i] = HashContents(std::vector<u64> {
+                HashContents(mesh.positions),
+                HashContents(mesh.normals),
+                HashContents(mesh.tex_coords),
+                HashContents(mesh.indices),
+                GetCanonicalMaterial(canonical_materials, mesh.material_idx),
+            });
+        }
+
+        auto IsSameMesh = [&](const scene_ir::Mesh& a, const scene_ir::Mesh& b) {
+            return SameContents(a.positions, b.positions)
+                && SameContents(a.normals, b.normals)
+                && SameContents(a.tex_coords, b.tex_coords)
+                && SameContents(a.indices, b.indices)
+                && GetCanonicalMaterial(canonical_materials, a.material_idx)
+                    == GetCanonicalMaterial(canonical_materials, b.material_idx);
+        };
+
+        // Hash collisions between different meshes are left unmerged
+
+        nova::HashMap<u64, u32> first_mesh;
+        u32 referenced_count = 0;
+        u32 unique_count = 0;
+        for (u32 i = 0; i < meshes.size(); ++i) {
+            if (!referenced[i] || matches[i].canonical_idx != i) {
+                continue;
+            }
+
+            referenced_count++;
+            auto[iter, inserted] = first_mesh.insert({ hashes[i], i });
+            if (!inserted && IsSameMesh(*meshes[iter->second], *meshes[i])) {
+                matches[i] = { iter->second, Mat4(1.f) };
+            } else {
+                unique_count++;
+            }
+        }
 
-        //     out_scene.instances.push_back(out_instance);
-        //     out_scene.meshes.push_back(joined_mesh);
-        // }
+        NOVA_LOG("Deduplicated meshes: {} -> {}", referenced_count, unique_count);
     }
 }
\ No newline at end of file
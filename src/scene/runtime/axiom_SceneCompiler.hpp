@@ -6,11 +6,169 @@
 
 namespace axiom
 {
+    // Ways in which a material samples a texture
+    enum class TextureRole : u32
+    {
+        BaseColor,
+        Normal,
+        Emissive,
+        MetalnessRoughness,
+        Transmission,
+
+        Count,
+    };
+
+    struct TextureUsage
+    {
+        // Bit per TextureRole
+        u32 roles = 0;
+
+        bool HasRole(TextureRole role) const
+        {
+            return roles & (1u << u32(role));
+        }
+    };
+
+    // Edges from input materials to the textures they sample, and the roles in which
+    // each texture is sampled
+    struct TextureUsageGraph
+    {
+        // Input texture bound to each role by each input material, or InvalidIndex
+        std::vector<std::array<u32, u32(TextureRole::Count)>> material_textures;
+        std::vector<TextureUsage>                                      textures;
+
+        u32 Get(u32 material_idx, TextureRole role) const
+        {
+            return material_textures[material_idx][u32(role)];
+        }
+    };
+
     struct SceneCompiler
     {
         bool          flip_uvs = false;
         bool flip_normal_map_z = false;
 
+        // Strip invalid, degenerate and duplicate triangles and invalid attributes from
+        // referenced input meshes before any other mesh pass. Sanitised in place when the
+        // input scene is consumed, otherwise on copies of the meshes that need changes
+        bool sanitise_meshes = true;
+
+        struct SanitiseStats
+        {
+            u64  non_finite_positions = 0;
+            u64    invalid_attributes = 0;
+            u64 out_of_range_triangles = 0;
+            u64  degenerate_triangles = 0;
+            u64   duplicate_triangles = 0;
+            u64      trimmed_vertices = 0;
+        };
+
+        // Reuse compiled meshes from previous runs when their contents and the
+        // options below are unchanged. Each compile replaces the cache manifest of
+        // cache_source, typically the source path, and entries no longer listed by
+        // any manifest are removed. Only enabled when cache_source is set
+        bool cache_meshes = true;
+        std::string cache_source;
+
+        struct MeshStats
+        {
+            u64    source_vertices = 0;
+            u64    welded_vertices = 0;
+            u32       split_meshes = 0;
+            u32      output_meshes = 0;
+            u64  quantise_vertices = 0;
+            u64 quantised_vertices = 0;
+            f32 quantisation_error = 0.f;
+            u64            indices = 0;
+            u64        indices_u16 = 0;
+            bool            cached = false;
+        };
+
+        // Merge vertices with bit-identical positions and shading attributes
+        bool weld_vertices = true;
+
+        // Split sub meshes above split_triangle_threshold triangles into separate
+        // spatially compact meshes, duplicating vertices along chunk borders. Zero disables
+        u32 split_triangle_threshold = 0;
+
+        // Sort triangles within each sub mesh by the Morton code of their centroids,
+        // and renumber vertices in order of first use
+        bool reorder_triangles = false;
+
+        // Number of simplified levels generated for each sub mesh. Each level targets
+        // lod_target_ratio of the previous level's triangles, and generation stops early
+        // once the error exceeds lod_max_error (relative to the sub mesh bounding radius)
+        u32        lod_levels = 0;
+        f32  lod_target_ratio = 0.5f;
+        f32     lod_max_error = 0.1f;
+
+        // Store sub mesh indices as u16 when every vertex index fits
+        bool compact_indices = true;
+
+        // Replace float positions with 16-bit fixed point relative to each sub mesh's bounds
+        bool quantise_positions = false;
+
+        // Share a single UVMaterial between materials with identical textures and flags
+        bool deduplicate_materials = true;
+
+        // Compile source meshes with identical contents and materials once, and share
+        // the result between their instances
+        bool deduplicate_meshes = true;
+
+        // Convert meshes that are rigid or uniformly scaled copies of another mesh into
+        // instances of it. Positions must match within rigid_match_tolerance, relative
+        // to the mesh's bounding radius
+        bool deduplicate_rigid_meshes = true;
+        f32     rigid_match_tolerance = 1e-4f;
+
+        // Combine all meshes of an instance group (e.g. glTF mesh primitives) into a
+        // single TriMesh with one sub mesh per part
+        bool merge_primitives = true;
+
+        // Pre-transform instances whose meshes are used exactly once into world space
+        // batches of roughly flatten_target_triangles, clustered by location. Batches
+        // are built in compiler owned storage, the input scene is left unmodified
+        bool flatten_unique_instances = false;
+        u32  flatten_target_triangles = 32 * 1024;
+
+        struct MeshRemap
+        {
+            // A single mesh, unless split into spatial chunks
+            std::vector<Index<TriMesh>> meshes;
+            Mat4                     transform = Mat4(1.f);
+        };
+
+        struct RigidMatch
+        {
+            u32   canonical_idx;
+            Mat4      transform;
+        };
+
         void Compile(scene_ir::Scene& in_scene, CompiledScene& out_scene);
+
+        // Moves geometry out of in_scene instead of copying it, releasing source
+        // textures and meshes as they are compiled. in_scene is left empty of data
+        void Compile(scene_ir::Scene&& in_scene, CompiledScene& out_scene);
+
+        void CompileScene(scene_ir::Scene& in_scene, CompiledScene& out_scene, bool consume);
+
+        void BuildTextureUsage(const scene_ir::Scene& scene, TextureUsageGraph& graph);
+        u64 HashMeshOptions();
+        void CompileMesh(scene_ir::Mesh& in_mesh, bool consume, std::vector<TriMesh>& out_meshes, MeshStats& stats);
+        void SanitiseMesh(scene_ir::Mesh& mesh, SanitiseStats& stats);
+        void FindRigidMatches(std::span<const scene_ir::Mesh* const> meshes, const std::vector<u32>& canonical_materials,
+            const std::vector<u8>& referenced, std::vector<RigidMatch>& matches);
+        bool FlattenInstances(std::span<const scene_ir::Mesh* const> meshes, std::span<const scene_ir::Instance> instances,
+            const std::vector<u32>& canonical_materials, std::vector<RigidMatch>& rigid_matches,
+            std::vector<scene_ir::Mesh>& out_meshes, std::vector<scene_ir::Instance>& out_instances);
+        void WeldVertices(TriMesh& mesh);
+        void ReorderTriangles(TriMesh& mesh);
+        void SplitMesh(const TriMesh& mesh, std::vector<TriMesh>& chunks);
+        void GenerateLods(TriMesh& mesh);
+        void PackIndices(TriMesh& mesh);
+        void QuantisePositions(TriMesh& mesh);
+        TriMesh MergeMeshes(const CompiledScene& scene, const std::vector<Index<TriMesh>>& parts);
+        void DeduplicateMeshes(std::span<const scene_ir::Mesh* const> meshes, const std::vector<u32>& canonical_materials,
+            const std::vector<u8>& referenced, std::vector<RigidMatch>& matches);
     };
 }
\ No newline at end of file
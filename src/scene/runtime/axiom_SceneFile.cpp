@@ -0,0 +1,533 @@
+#include "axiom_SceneFile.hpp"
+
+#include <nova/core/nova_Files.hpp>
+#include <nova/core/nova_Guards.hpp>
+#include <nova/core/nova_ToString.hpp>
+
+#ifdef _WIN32
+#  include <nova/core/win32/nova_Win32Include.hpp>
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+namespace axiom
+{
+    static_assert(sizeof(shading_attributes_t) == sizeof(ShadingAttributes));
+    static_assert(sizeof(quantised_position_t) == sizeof(GPU_QuantisedPosition));
+    static_assert(sizeof(vec3_t) == sizeof(Vec3) && alignof(vec3_t) == alignof(Vec3));
+    static_assert(TransformHierarchy::InvalidNode == UINT32_MAX);
+
+    namespace
+    {
+        u64 AlignSection(u64 offset)
+        {
+            return (offset + scene_file_alignment - 1) & ~(scene_file_alignment - 1);
+        }
+
+        vec3_t ToFile(Vec3 v)
+        {
+            return { v.x, v.y, v.z };
+        }
+
+        Vec3 FromFile(const vec3_t& v)
+        {
+            return Vec3(v.x, v.y, v.z);
+        }
+
+        mat4x3_t ToFile(const Mat4x3& m)
+        {
+            return { ToFile(m[0]), ToFile(m[1]), ToFile(m[2]), ToFile(m[3]) };
+        }
+
+        Mat4x3 FromFile(const mat4x3_t& m)
+        {
+            return Mat4x3(FromFile(m.cols[0]), FromFile(m.cols[1]), FromFile(m.cols[2]), FromFile(m.cols[3]));
+        }
+
+        bool InRange(u64 offset, u64 count, u64 size)
+        {
+            return offset <= size && count <= size - offset;
+        }
+    }
+
+    void WriteSceneFile(const CompiledScene& scene, const std::filesystem::path& path)
+    {
+        std::vector<vec3_t>               positions;
+        std::vector<quantised_position_t> quantised_positions;
+        std::vector<shading_attributes_t> shading_attributes;
+        std::vector<u32_t>                indices;
+        std::vector<u16_t>                indices_u16;
+        std::vector<lod_t>                lods;
+        std::vector<mesh_t>               meshes;
+        std::vector<geometry_t>           geometries;
+        std::vector<byte_t>               texture_data;
+        std::vector<texture_t>            textures;
+        std::vector<material_t>           materials;
+        std::vector<node_t>               nodes;
+        std::vector<instance_t>           instances;
+
+        // Every TriMesh becomes a geometry_t, with its sub meshes as mesh_t. Geometry
+        // is written in its compiled format so that it can be used in place when mapped
+
+        for (auto& mesh : scene.meshes) {
+            auto data = mesh.GetData();
+
+            geometries.push_back(geometry_t {
+                .vertex_offset = u32(shading_attributes.size()),
+                .position_offset = u32(mesh.IsQuantised() ? quantised_positions.size() : positions.size()),
+                .vertex_count = u32(mesh.GetVertexCount()),
+                .index_offset = u32(indices.size()),
+                .index_count = u32(data.indices.size()),
+                .index_u16_offset = u32(indices_u16.size()),
+                .index_u16_count = u32(data.indices_u16.size()),
+                .first_mesh = u32(meshes.size()),
+                .mesh_count = u32(mesh.sub_meshes.size()),
+                .flags = mesh.IsQuantised() ? u32_t(geometry_quantised) : 0u,
+                .quantisation_error = mesh.quantisation_error,
+                .bounds_min = ToFile(mesh.bounds_min),
+                .bounds_max = ToFile(mesh.bounds_max),
+            });
+
+            if (mesh.IsQuantised()) {
+                for (auto& position : data.quantised_positions) {
+                    quantised_positions.push_back({ position.x, position.y, position.z });
+                }
+            } else {
+                for (auto& position : data.position_attributes) {
+                    positions.push_back(ToFile(position));
+                }
+            }
+
+            for (auto& attributes : data.shading_attributes) {
+                shading_attributes.push_back(std::bit_cast<shading_attributes_t>(attributes));
+            }
+
+            indices.insert(indices.end(), data.indices.begin(), data.indices.end());
+            indices_u16.insert(indices_u16.end(), data.indices_u16.begin(), data.indices_u16.end());
+
+            for (auto& sub_mesh : mesh.sub_meshes) {
+                meshes.push_back(mesh_t {
+                    .vertex_offset = sub_mesh.vertex_offset,
+                    .max_vertex = sub_mesh.max_vertex,
+                    .index_offset = sub_mesh.first_index,
+                    .index_count = sub_mesh.index_count,
+                    .material = sub_mesh.material.value,
+                    .index_type = sub_mesh.index_type == nova::IndexType::U16 ? u32_t(index_type_u16) : u32_t(index_type_u32),
+                    .first_lod = u32(lods.size()),
+                    .lod_count = u32(sub_mesh.lods.size()),
+                    .bounds_min = ToFile(sub_mesh.bounds_min),
+                    .bounds_max = ToFile(sub_mesh.bounds_max),
+                    .bounding_center = ToFile(sub_mesh.bounding_center),
+                    .bounding_radius = sub_mesh.bounding_radius,
+                    .dequant_offset = ToFile(sub_mesh.dequant_offset),
+                    .dequant_scale = ToFile(sub_mesh.dequant_scale),
+                });
+
+                for (auto& lod : sub_mesh.lods) {
+                    lods.push_back({ lod.first_index, lod.index_count, lod.error });
+                }
+            }
+        }
+
+        for (auto& texture : scene.textures) {
+            if (texture.size.x > UINT16_MAX || texture.size.y > UINT16_MAX) {
+                NOVA_THROW("Texture size ({}, {}) exceeds scene file limits", texture.size.x, texture.size.y);
+            }
+
+            auto data = texture.GetData();
+            u64 data_offset = AlignSection(texture_data.size());
+            texture_data.resize(data_offset + data.size());
+            std::memcpy(texture_data.data() + data_offset, data.data(), data.size());
+
+            textures.push_back(texture_t {
+                .data_offset = data_offset,
+                .data_size = data.size(),
+                .width = u16_t(texture.size.x),
+                .height = u16_t(texture.size.y),
+                .type = u16_t(texture.format),
+                .flags = 0,
+            });
+        }
+
+        for (auto& material : scene.materials) {
+            u32_t flags = 0;
+            if (material.alpha_mask)  flags |= material_alpha_mask;
+            if (material.alpha_blend) flags |= material_alpha_blend;
+            if (material.thin)        flags |= material_thin;
+            if (material.subsurface)  flags |= material_subsurface;
+            if (material.decal)       flags |= material_decal;
+
+            materials.push_back(material_t {
+                .albedo_alpha = material.basecolor_alpha.value,
+                .normal = material.normals.value,
+                .metalness_roughness = material.metalness_roughness.value,
+                .emissive = material.emissivity.value,
+                .transmission = material.transmission.value,
+                .flags = flags,
+                .ior = 1.5f,
+                .alpha_cutoff = material.alpha_cutoff,
+            });
+        }
+
+        // Node ids follow insertion order, so parents already precede their children
+
+        for (u32 i = 0; i < scene.transforms.GetNodeCount(); ++i) {
+            nodes.push_back(node_t {
+                .transform = ToFile(scene.transforms.GetLocal(i)),
+                .parent = scene.transforms.GetParent(i),
+            });
+        }
+
+        for (auto& instance : scene.instances) {
+            instances.push_back(instance_t {
+                .node = instance.node,
+                .geometry = instance.mesh.value,
+                .transform = ToFile(instance.transform),
+            });
+        }
+
+        // Lay out sections after the header
+
+        scene_file_header_t header = {};
+        header.magic = scene_file_magic;
+        header.version = scene_file_version;
+        header.header_size = sizeof(scene_file_header_t);
+
+        struct Section
+        {
+            const void* data;
+            u64         size;
+            u64       offset;
+        };
+
+        std::vector<Section> sections;
+        u64 file_size = sizeof(scene_file_header_t);
+
+        auto AddSection = [&]<class T>(span_t<T>& span, const std::vector<T>& data) {
+            file_size = AlignSection(file_size);
+            span.first = std::bit_cast<T*>(file_size);
+            span.count = data.size();
+            sections.push_back({ data.data(), data.size() * sizeof(T), file_size });
+            file_size += data.size() * sizeof(T);
+        };
+
+        AddSection(header.scene.pos_attributes, positions);
+        AddSection(header.scene.quantised_positions, quantised_positions);
+        AddSection(header.scene.shading_attributes, shading_attributes);
+        AddSection(header.scene.vertex_indices, indices);
+        AddSection(header.scene.vertex_indices_u16, indices_u16);
+        AddSection(header.scene.lods, lods);
+        AddSection(header.scene.meshes, meshes);
+        AddSection(header.scene.geometries, geometries);
+        AddSection(header.scene.texture_data, texture_data);
+        AddSection(header.scene.textures, textures);
+        AddSection(header.scene.materials, materials);
+        AddSection(header.scene.nodes, nodes);
+        AddSection(header.scene.instances, instances);
+
+        file_size = AlignSection(file_size);
+        header.file_size = file_size;
+
+        nova::File file{ path.string().c_str(), true };
+        file.Write(header);
+
+        std::array<byte_t, scene_file_alignment> padding = {};
+        u64 offset = sizeof(scene_file_header_t);
+        for (auto& section : sections) {
+            file.Write(padding.data(), section.offset - offset);
+            file.Write(section.data, section.size);
+            offset = section.offset + section.size;
+        }
+        file.Write(padding.data(), file_size - offset);
+
+        NOVA_LOG("Wrote scene file [{}], {}", path.string(), nova::ByteSizeToString(file_size));
+    }
+
+    void CompiledScene::Load(const scene_t& scene)
+    {
+        // Everything is validated up front, so a malformed file throws before the
+        // scene is modified. Index values themselves are not scanned, max_vertex is
+        // trusted to bound them
+
+        for (u32 i = 0; i < scene.textures.count; ++i) {
+            auto& in_texture = scene.textures.first[i];
+            if (!InRange(in_texture.data_offset, in_texture.data_size, scene.texture_data.count)) {
+                NOVA_THROW("Scene file texture[{}] data out of bounds", i);
+            }
+        }
+
+        for (u32 i = 0; i < scene.materials.count; ++i) {
+            auto& in_material = scene.materials.first[i];
+            for (u32 texture : { in_material.albedo_alpha, in_material.normal, in_material.metalness_roughness,
+                    in_material.emissive, in_material.transmission }) {
+                if (texture != UINT32_MAX && texture >= scene.textures.count) {
+                    NOVA_THROW("Scene file material[{}] references missing texture {}", i, texture);
+                }
+            }
+        }
+
+        for (u32 i = 0; i < scene.geometries.count; ++i) {
+            auto& in_geometry = scene.geometries.first[i];
+            bool quantised = in_geometry.flags & geometry_quantised;
+            u64 position_count = quantised ? scene.quantised_positions.count : scene.pos_attributes.count;
+
+            if (!InRange(in_geometry.vertex_offset, in_geometry.vertex_count, scene.shading_attributes.count)
+                    || !InRange(in_geometry.position_offset, in_geometry.vertex_count, position_count)
+                    || !InRange(in_geometry.index_offset, in_geometry.index_count, scene.vertex_indices.count)
+                    || !InRange(in_geometry.index_u16_offset, in_geometry.index_u16_count, scene.vertex_indices_u16.count)
+                    || !InRange(in_geometry.first_mesh, in_geometry.mesh_count, scene.meshes.count)) {
+                NOVA_THROW("Scene file geometry[{}] out of bounds", i);
+            }
+
+            for (u32 j = 0; j < in_geometry.mesh_count; ++j) {
+                auto& in_mesh = scene.meshes.first[in_geometry.first_mesh + j];
+                u32 index_count = in_mesh.index_type == index_type_u16 ? in_geometry.index_u16_count : in_geometry.index_count;
+
+                if (in_mesh.index_type != index_type_u32 && in_mesh.index_type != index_type_u16) {
+                    NOVA_THROW("Scene file mesh[{}] has unknown index type {}", in_geometry.first_mesh + j, in_mesh.index_type);
+                }
+                if (in_mesh.material != UINT32_MAX && in_mesh.material >= scene.materials.count) {
+                    NOVA_THROW("Scene file mesh[{}] references missing material {}", in_geometry.first_mesh + j, in_mesh.material);
+                }
+                if (u64(in_mesh.vertex_offset) + in_mesh.max_vertex >= in_geometry.vertex_count
+                        || !InRange(in_mesh.index_offset, in_mesh.index_count, index_count)
+                        || !InRange(in_mesh.first_lod, in_mesh.lod_count, scene.lods.count)) {
+                    NOVA_THROW("Scene file mesh[{}] out of bounds", in_geometry.first_mesh + j);
+                }
+
+                for (u32 k = 0; k < in_mesh.lod_count; ++k) {
+                    auto& in_lod = scene.lods.first[in_mesh.first_lod + k];
+                    if (!InRange(in_lod.first_index, in_lod.index_count, index_count)) {
+                        NOVA_THROW("Scene file lod[{}] out of bounds", in_mesh.first_lod + k);
+                    }
+                }
+            }
+        }
+
+        for (u32 i = 0; i < scene.nodes.count; ++i) {
+            // Requiring parents to come first also rules out cycles
+            u32 parent = scene.nodes.first[i].parent;
+            if (parent != UINT32_MAX && parent >= i) {
+                NOVA_THROW("Scene file node[{}] has invalid parent {}", i, parent);
+            }
+        }
+
+        for (u32 i = 0; i < scene.instances.count; ++i) {
+            auto& in_instance = scene.instances.first[i];
+            if ((in_instance.node != UINT32_MAX && in_instance.node >= scene.nodes.count)
+                    || in_instance.geometry >= scene.geometries.count) {
+                NOVA_THROW("Scene file instance[{}] out of bounds", i);
+            }
+        }
+
+        // Textures and geometry reference the mapping directly, see MappedSceneFile
+
+        u32 texture_offset = u32(textures.size());
+        u32 material_offset = u32(materials.size());
+        u32 mesh_offset = u32(meshes.size());
+
+        auto OffsetIndex = [](u32 index, u32 offset) {
+            return index == UINT32_MAX ? index : index + offset;
+        };
+
+        for (u32 i = 0; i < scene.textures.count; ++i) {
+            auto& in_texture = scene.textures.first[i];
+            auto& texture = textures.emplace_back();
+            texture.size = Vec2U(in_texture.width, in_texture.height);
+            texture.format = nova::Format(in_texture.type);
+            texture.mapped = std::span(reinterpret_cast<const b8*>(scene.texture_data.first + in_texture.data_offset), in_texture.data_size);
+        }
+
+        for (u32 i = 0; i < scene.materials.count; ++i) {
+            auto& in_material = scene.materials.first[i];
+            auto& material = materials.emplace_back();
+            material.basecolor_alpha = OffsetIndex(in_material.albedo_alpha, texture_offset);
+            material.normals = OffsetIndex(in_material.normal, texture_offset);
+            material.metalness_roughness = OffsetIndex(in_material.metalness_roughness, texture_offset);
+            material.emissivity = OffsetIndex(in_material.emissive, texture_offset);
+            material.transmission = OffsetIndex(in_material.transmission, texture_offset);
+            material.alpha_cutoff = in_material.alpha_cutoff;
+            material.alpha_mask = in_material.flags & material_alpha_mask;
+            material.alpha_blend = in_material.flags & material_alpha_blend;
+            material.thin = in_material.flags & material_thin;
+            material.subsurface = in_material.flags & material_subsurface;
+            material.decal = in_material.flags & material_decal;
+        }
+
+        for (u32 i = 0; i < scene.geometries.count; ++i) {
+            auto& in_geometry = scene.geometries.first[i];
+            auto& mesh = meshes.emplace_back();
+
+            TriMeshData data;
+            data.shading_attributes = { reinterpret_cast<const ShadingAttributes*>(scene.shading_attributes.first + in_geometry.vertex_offset), in_geometry.vertex_count };
+            data.indices = { scene.vertex_indices.first + in_geometry.index_offset, in_geometry.index_count };
+            data.indices_u16 = { scene.vertex_indices_u16.first + in_geometry.index_u16_offset, in_geometry.index_u16_count };
+            if (in_geometry.flags & geometry_quantised) {
+                data.quantised_positions = { reinterpret_cast<const GPU_QuantisedPosition*>(scene.quantised_positions.first + in_geometry.position_offset), in_geometry.vertex_count };
+            } else {
+                data.position_attributes = { reinterpret_cast<const Vec3*>(scene.pos_attributes.first + in_geometry.position_offset), in_geometry.vertex_count };
+            }
+            mesh.mapped = data;
+
+            mesh.quantisation_error = in_geometry.quantisation_error;
+            mesh.bounds_min = FromFile(in_geometry.bounds_min);
+            mesh.bounds_max = FromFile(in_geometry.bounds_max);
+
+            for (u32 j = 0; j < in_geometry.mesh_count; ++j) {
+                auto& in_mesh = scene.meshes.first[in_geometry.first_mesh + j];
+                auto& sub_mesh = mesh.sub_meshes.emplace_back(TriSubMesh {
+                    .vertex_offset = in_mesh.vertex_offset,
+                    .max_vertex = in_mesh.max_vertex,
+                    .first_index = in_mesh.index_offset,
+                    .index_count = in_mesh.index_count,
+                    .material = OffsetIndex(in_mesh.material, material_offset),
+                    .index_type = in_mesh.index_type == index_type_u16 ? nova::IndexType::U16 : nova::IndexType::U32,
+                    .bounds_min = FromFile(in_mesh.bounds_min),
+                    .bounds_max = FromFile(in_mesh.bounds_max),
+                    .bounding_center = FromFile(in_mesh.bounding_center),
+                    .bounding_radius = in_mesh.bounding_radius,
+                    .dequant_offset = FromFile(in_mesh.dequant_offset),
+                    .dequant_scale = FromFile(in_mesh.dequant_scale),
+                });
+
+                for (u32 k = 0; k < in_mesh.lod_count; ++k) {
+                    auto& in_lod = scene.lods.first[in_mesh.first_lod + k];
+                    sub_mesh.lods.push_back({ in_lod.first_index, in_lod.index_count, in_lod.error });
+                }
+            }
+        }
+
+        // Nodes keep their relative order, so parents still precede their children
+
+        u32 node_offset = u32(transforms.GetNodeCount());
+        for (u32 i = 0; i < scene.nodes.count; ++i) {
+            auto& in_node = scene.nodes.first[i];
+            transforms.Add(OffsetIndex(in_node.parent, node_offset), FromFile(in_node.transform));
+        }
+
+        for (u32 i = 0; i < scene.instances.count; ++i) {
+            auto& in_instance = scene.instances.first[i];
+            auto& instance = instances.emplace_back();
+            instance.mesh = mesh_offset + in_instance.geometry;
+            instance.node = OffsetIndex(in_instance.node, node_offset);
+            instance.transform = FromFile(in_instance.transform);
+            ComputeWorldBounds(Get(instance.mesh), instance);
+        }
+
+        // Resolves world transforms of the new nodes and their instances
+
+        UpdateTransforms();
+    }
+
+    MappedSceneFile::MappedSceneFile(const std::filesystem::path& path)
+    {
+        // Mapped copy-on-write so that only the header page is dirtied by fixups
+
+#ifdef _WIN32
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            NOVA_THROW("Failed to open scene file [{}]", path.string());
+        }
+        NOVA_DEFER(&) { CloseHandle(file); };
+
+        LARGE_INTEGER file_size;
+        GetFileSizeEx(file, &file_size);
+        size = usz(file_size.QuadPart);
+
+        HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+        if (!mapping) {
+            NOVA_THROW("Failed to map scene file [{}]", path.string());
+        }
+        NOVA_DEFER(&) { CloseHandle(mapping); };
+
+        base = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+        if (!base) {
+            NOVA_THROW("Failed to map scene file [{}]", path.string());
+        }
+#else
+        int file = open(path.c_str(), O_RDONLY);
+        if (file < 0) {
+            NOVA_THROW("Failed to open scene file [{}]", path.string());
+        }
+        NOVA_DEFER(&) { close(file); };
+
+        struct stat stats;
+        fstat(file, &stats);
+        size = usz(stats.st_size);
+
+        base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+        if (base == MAP_FAILED) {
+            base = nullptr;
+            NOVA_THROW("Failed to map scene file [{}]", path.string());
+        }
+#endif
+
+        auto Fail = [&](std::string_view reason) {
+            Unmap();
+            NOVA_THROW("Invalid scene file [{}]: {}", path.string(), reason);
+        };
+
+        if (size < sizeof(scene_file_header_t)) {
+            Fail("truncated header");
+        }
+
+        auto header = static_cast<scene_file_header_t*>(base);
+        if (header->magic != scene_file_magic) {
+            Fail("bad magic");
+        }
+        if (header->version != scene_file_version || header->header_size != sizeof(scene_file_header_t)) {
+            Fail(std::format("unsupported version {}", header->version));
+        }
+        if (header->file_size != size) {
+            Fail("size mismatch");
+        }
+
+        auto FixupSection = [&]<class T>(span_t<T>& span) {
+            u64 offset = std::bit_cast<u64>(span.first);
+            if (offset % scene_file_alignment || offset > size || span.count > (size - offset) / sizeof(T)) {
+                Fail("section out of bounds");
+            }
+            span.first = reinterpret_cast<T*>(static_cast<byte_t*>(base) + offset);
+        };
+
+        auto& s = header->scene;
+        FixupSection(s.pos_attributes);
+        FixupSection(s.quantised_positions);
+        FixupSection(s.shading_attributes);
+        FixupSection(s.vertex_indices);
+        FixupSection(s.vertex_indices_u16);
+        FixupSection(s.lods);
+        FixupSection(s.meshes);
+        FixupSection(s.geometries);
+        FixupSection(s.texture_data);
+        FixupSection(s.textures);
+        FixupSection(s.materials);
+        FixupSection(s.nodes);
+        FixupSection(s.instances);
+
+        scene = &header->scene;
+    }
+
+    MappedSceneFile::~MappedSceneFile()
+    {
+        Unmap();
+    }
+
+    void MappedSceneFile::Unmap()
+    {
+        if (!base) {
+            return;
+        }
+
+#ifdef _WIN32
+        UnmapViewOfFile(base);
+#else
+        munmap(base, size);
+#endif
+        base = nullptr;
+        scene = nullptr;
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "axiom_CompiledScene.hpp"
+
+#include "scene.hpp"
+
+namespace axiom
+{
+    // Writes a compiled scene in the scene_t file layout. Geometry keeps its compiled
+    // index and position formats, along with levels of detail and bounds, and the
+    // transform hierarchy is stored as local transforms, so that loading reproduces
+    // the scene exactly
+    void WriteSceneFile(const CompiledScene& scene, const std::filesystem::path& path);
+
+    // Copy-on-write mapping of a scene file. Section offsets are replaced with
+    // pointers into the mapping on open, which stays valid until destruction.
+    // Scenes loaded from the mapping reference its geometry and texture data,
+    // so it must outlive them
+    class MappedSceneFile
+    {
+        void* base = nullptr;
+        usz   size = 0;
+
+        void Unmap();
+
+    public:
+        const scene_t* scene = nullptr;
+
+        MappedSceneFile(const std::filesystem::path& path);
+        ~MappedSceneFile();
+
+        MappedSceneFile(const MappedSceneFile&) = delete;
+        MappedSceneFile& operator=(const MappedSceneFile&) = delete;
+    };
+}
@@ -0,0 +1,134 @@
+#include "axiom_TransformHierarchy.hpp"
+
+namespace axiom
+{
+    u32 TransformHierarchy::Add(u32 parent, const Mat4x3& local)
+    {
+        u32 node = u32(slots.size());
+        if (parent != InvalidNode && parent >= node) {
+            NOVA_THROW("Transform node parent {} added after child {}", parent, node);
+        }
+
+        // Appended out of depth order, levels are rebuilt on the next Update
+
+        slots.push_back(u32(node_ids.size()));
+        node_ids.push_back(node);
+        parents.push_back(parent);
+        depths.push_back(parent == InvalidNode ? 0 : depths[slots[parent]] + 1);
+        locals.push_back(local);
+        worlds.push_back(local);
+        dirty.push_back(1);
+        updated_frame.push_back(frame - 1);
+
+        needs_sort = true;
+
+        return node;
+    }
+
+    void TransformHierarchy::SetLocal(u32 node, const Mat4x3& local)
+    {
+        u32 slot = slots[node];
+        locals[slot] = local;
+
+        if (!dirty[slot]) {
+            dirty[slot] = 1;
+            if (!needs_sort) {
+                level_dirty[depths[slot]]++;
+            }
+        }
+    }
+
+    void TransformHierarchy::Sort()
+    {
+        // Counting sort by depth, stable so that nodes keep insertion order within a level
+
+        u32 level_count = 0;
+        for (u32 depth : depths) {
+            level_count = std::max(level_count, depth + 1);
+        }
+
+        level_offsets.assign(level_count + 1, 0);
+        for (u32 depth : depths) {
+            level_offsets[depth + 1]++;
+        }
+        for (u32 level = 0; level < level_count; ++level) {
+            level_offsets[level + 1] += level_offsets[level];
+        }
+
+        std::vector<u32> order(node_ids.size());
+        {
+            std::vector<u32> cursor(level_offsets.begin(), level_offsets.end() - 1);
+            for (u32 node = 0; node < slots.size(); ++node) {
+                order[cursor[depths[slots[node]]]++] = slots[node];
+            }
+        }
+
+        auto Permute = [&](auto& values) {
+            std::remove_cvref_t<decltype(values)> sorted(values.size());
+            for (u32 i = 0; i < order.size(); ++i) {
+                sorted[i] = values[order[i]];
+            }
+            values = std::move(sorted);
+        };
+
+        Permute(parents);
+        Permute(depths);
+        Permute(node_ids);
+        Permute(locals);
+        Permute(worlds);
+        Permute(dirty);
+        Permute(updated_frame);
+
+        for (u32 slot = 0; slot < node_ids.size(); ++slot) {
+            slots[node_ids[slot]] = slot;
+        }
+
+        level_dirty.assign(level_count, 0);
+        for (u32 slot = 0; slot < node_ids.size(); ++slot) {
+            level_dirty[depths[slot]] += dirty[slot];
+        }
+
+        needs_sort = false;
+    }
+
+    void TransformHierarchy::Update()
+    {
+        if (needs_sort) {
+            Sort();
+        }
+
+        frame++;
+
+        // A level only needs visiting if it contains dirty nodes, or if any node on
+        // the level above was updated
+
+        bool parent_level_updated = false;
+        for (u32 level = 0; level + 1 < level_offsets.size(); ++level) {
+            if (!level_dirty[level] && !parent_level_updated) {
+                continue;
+            }
+
+            u32 updated = 0;
+#pragma omp parallel for reduction(+:updated)
+            for (u32 slot = level_offsets[level]; slot < level_offsets[level + 1]; ++slot) {
+                u32 parent = parents[slot];
+                u32 parent_slot = parent == InvalidNode ? InvalidNode : slots[parent];
+
+                if (!dirty[slot] && (parent_slot == InvalidNode || updated_frame[parent_slot] != frame)) {
+                    continue;
+                }
+
+                worlds[slot] = parent_slot == InvalidNode
+                    ? locals[slot]
+                    : Mat4x3(Mat4(worlds[parent_slot]) * Mat4(locals[slot]));
+
+                dirty[slot] = 0;
+                updated_frame[slot] = frame;
+                updated++;
+            }
+
+            level_dirty[level] = 0;
+            parent_level_updated = updated > 0;
+        }
+    }
+}
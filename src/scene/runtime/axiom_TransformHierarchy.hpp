@@ -0,0 +1,55 @@
+#pragma once
+
+#include <axiom_Core.hpp>
+
+namespace axiom
+{
+    // Parent linked transform hierarchy. Nodes are identified by their insertion
+    // order, and internally stored sorted by depth so that parents always precede
+    // their children and each level can have its world transforms updated in
+    // parallel. Only subtrees below nodes changed since the last Update are touched
+    struct TransformHierarchy
+    {
+        static constexpr u32 InvalidNode = UINT32_MAX;
+
+    private:
+        // Per slot, in depth order
+        std::vector<u32>       parents;
+        std::vector<u32>        depths;
+        std::vector<u32>      node_ids;
+        std::vector<Mat4x3>     locals;
+        std::vector<Mat4x3>     worlds;
+        std::vector<u8>          dirty;
+        std::vector<u32> updated_frame;
+
+        // Node id to slot
+        std::vector<u32> slots;
+
+        // Slots [level_offsets[i], level_offsets[i + 1]) have depth i
+        std::vector<u32> level_offsets;
+        std::vector<u32>   level_dirty;
+
+        u32  frame = 0;
+        bool needs_sort = false;
+
+        void Sort();
+
+    public:
+        // Parents must have been added before their children
+        u32 Add(u32 parent, const Mat4x3& local);
+
+        void SetLocal(u32 node, const Mat4x3& local);
+
+        // Recomputes world transforms of dirty nodes and their descendants
+        void Update();
+
+        const Mat4x3& GetLocal(u32 node) const { return locals[slots[node]]; }
+        const Mat4x3& GetWorld(u32 node) const { return worlds[slots[node]]; }
+        u32          GetParent(u32 node) const { return parents[slots[node]]; }
+
+        // True if the node's world transform changed in the last Update
+        bool IsUpdated(u32 node) const { return updated_frame[slots[node]] == frame; }
+
+        usz GetNodeCount() const { return slots.size(); }
+    };
+}
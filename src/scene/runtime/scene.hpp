@@ -1,3 +1,5 @@
+#pragma once
+
 #include <cstdint>
 
 using byte_t = unsigned char;
@@ -17,6 +19,10 @@ struct mat4x3_t {
     vec3_t cols[4];
 };
 
+struct quantised_position_t {
+    u16_t x, y, z;
+};
+
 struct shading_attributes_t {
     u32_t normal_x       : 10;
     u32_t normal_y       : 10;
@@ -28,36 +34,100 @@ struct shading_attributes_t {
     f16_t v;
 };
 
-struct mesh_t {
-    u32_t vertex_offset;
-    u32_t index_offset;
+struct lod_t {
+    u32_t first_index;
     u32_t index_count;
-    u32_t material;
+    f32_t error;
+};
+
+enum index_type_t : u32_t {
+    index_type_u32 = 0,
+    index_type_u16 = 1,
+};
+
+// Sub mesh of a geometry_t. Vertex and index offsets are relative to the
+// ranges of the owning geometry, in the index section selected by index_type
+struct mesh_t {
+    u32_t  vertex_offset;
+    u32_t  max_vertex;
+    u32_t  index_offset;
+    u32_t  index_count;
+    u32_t  material;
+    u32_t  index_type;
+    u32_t  first_lod;
+    u32_t  lod_count;
+    vec3_t bounds_min;
+    vec3_t bounds_max;
+    vec3_t bounding_center;
+    f32_t  bounding_radius;
+    vec3_t dequant_offset;
+    vec3_t dequant_scale;
+};
+
+enum geometry_flags_t : u32_t {
+    geometry_quantised = 1 << 0,
+};
+
+// Positions of a quantised geometry start at position_offset in
+// quantised_positions instead of pos_attributes. Shading attributes start
+// at vertex_offset
+struct geometry_t {
+    u32_t  vertex_offset;
+    u32_t  position_offset;
+    u32_t  vertex_count;
+    u32_t  index_offset;
+    u32_t  index_count;
+    u32_t  index_u16_offset;
+    u32_t  index_u16_count;
+    u32_t  first_mesh;
+    u32_t  mesh_count;
+    u32_t  flags;
+    f32_t  quantisation_error;
+    vec3_t bounds_min;
+    vec3_t bounds_max;
 };
 
 struct texture_t {
     u64_t data_offset;
+    u64_t data_size;
     u16_t width;
     u16_t height;
     u16_t type;
     u16_t flags;
 };
 
+enum material_flags_t : u32_t {
+    material_alpha_mask  = 1 << 0,
+    material_alpha_blend = 1 << 1,
+    material_thin        = 1 << 2,
+    material_subsurface  = 1 << 3,
+    material_decal       = 1 << 4,
+};
+
 struct material_t {
     u32_t albedo_alpha;
     u32_t normal;
     u32_t metalness_roughness;
     u32_t emissive;
+    u32_t transmission;
 
     u32_t flags;
     f32_t ior;
+    f32_t alpha_cutoff;
 };
 
+// Transforms are relative to the parent node, parents precede their children
 struct node_t {
     mat4x3_t transform;
     u32_t    parent;
-    u32_t    first_instance;
-    u32_t    mesh_count;
+};
+
+// Instances attached to a node take their transform from it, static instances
+// have no node and use transform directly
+struct instance_t {
+    u32_t    node;
+    u32_t    geometry;
+    mat4x3_t transform;
 };
 
 template<class T>
@@ -68,14 +138,42 @@ struct span_t {
 
 struct scene_t {
     span_t<vec3_t>               pos_attributes;
+    span_t<quantised_position_t> quantised_positions;
     span_t<shading_attributes_t> shading_attributes;
     span_t<u32_t>                vertex_indices;
+    span_t<u16_t>                vertex_indices_u16;
 
+    span_t<lod_t>                lods;
     span_t<mesh_t>               meshes;
+    span_t<geometry_t>           geometries;
     span_t<byte_t>               texture_data;
     span_t<texture_t>            textures;
     span_t<material_t>           materials;
 
-    span_t<u32_t>                mesh_instances;
     span_t<node_t>               nodes;
+    span_t<instance_t>           instances;
 };
+
+// -----------------------------------------------------------------------------
+//                                 File layout
+// -----------------------------------------------------------------------------
+//
+// [scene_file_header_t][section 0][section 1]...
+//
+// Sections start on scene_file_alignment boundaries. On disk every span_t::first
+// holds the byte offset of its section from the start of the file, which is
+// turned into a pointer by adding the mapped base address
+
+constexpr u64_t scene_file_magic     = 0x00454E45'43535841; // "AXSCENE"
+constexpr u32_t scene_file_version   = 3;
+constexpr u64_t scene_file_alignment = 64;
+
+struct scene_file_header_t {
+    u64_t   magic;
+    u32_t   version;
+    u32_t   header_size;
+    u64_t   file_size;
+    scene_t scene;
+};
+
+static_assert(sizeof(void*) == sizeof(u64_t), "scene files store offsets in pointer sized fields");
@@ -2,6 +2,7 @@
 
 #include <scene/axiom_Scene.hpp>
 #include <scene/runtime/axiom_SceneCompiler.hpp>
+#include <scene/runtime/axiom_SceneFile.hpp>
 #include <scene/import/axiom_GltfImporter.hpp>
 #include <scene/import/axiom_FbxImporter.hpp>
 #include <scene/import/axiom_AssimpImporter.hpp>
@@ -24,7 +25,9 @@ constexpr std::string_view UsageString =
     "  --path-trace  : Path tracing renderer\n"
     "  --flip-uvs    : Flip UVs vertically\n"
     "  --flip-nmap-z : Flip normal map Z axis\n"
+    "  --lods        : Generate simplified levels of detail\n"
     "  --assimp      : Use assimp importer (experimental)\n"
+    "  --write-scene : Write compiled scene next to the last input as .axscene\n"
     "  --raster      : Raster renderer";
 
 int main(int argc, char* argv[])
@@ -37,6 +40,7 @@ int main(int argc, char* argv[])
     bool path_trace = false;
     bool raster = false;
     bool use_assimp = false;
+    bool write_scene = false;
     std::vector<std::filesystem::path> paths;
 
     for (i32 i = 1; i < argc; ++i) {
@@ -50,8 +54,12 @@ int main(int argc, char* argv[])
             compiler.flip_uvs = true;
         } else if (arg == "--flip-nmap-z") {
             compiler.flip_normal_map_z = true;
+        } else if (arg == "--lods") {
+            compiler.lod_levels = 4;
         } else if (arg == "--assimp") {
             use_assimp = true;
+        } else if (arg == "--write-scene") {
+            write_scene = true;
         } else {
             try {
                 auto path = std::filesystem::path(arg);
@@ -87,10 +95,19 @@ int main(int argc, char* argv[])
 
     axiom::CompiledScene compiled_scene;
 
+    // Loaded scene files are referenced in place, and must stay mapped while the scene is used
+    std::vector<std::unique_ptr<axiom::MappedSceneFile>> scene_files;
+
     for (auto& path : paths) {
         auto ext = path.extension().string();
         std::transform(ext.begin(), ext.end(), ext.begin(), [](char c) { return char(std::tolower(c)); });
 
+        if (ext == ".axscene") {
+            auto& file = scene_files.emplace_back(std::make_unique<axiom::MappedSceneFile>(path));
+            compiled_scene.Load(*file->scene);
+            continue;
+        }
+
         axiom::scene_ir::Scene scene;
 
         if (use_assimp) {
@@ -104,7 +121,12 @@ int main(int argc, char* argv[])
         }
 
         // scene.Debug();
-        compiler.Compile(scene, compiled_scene);
+        compiler.cache_source = std::filesystem::absolute(path).string();
+        compiler.Compile(std::move(scene), compiled_scene);
+    }
+
+    if (write_scene) {
+        axiom::WriteSceneFile(compiled_scene, std::filesystem::path(paths.back()).replace_extension(".axscene"));
     }
 
     // {
@@ -0,0 +1,68 @@
+#include "axiom_Test.hpp"
+
+#include <scene/runtime/axiom_CompiledScene.hpp>
+
+#include <random>
+
+using namespace axiom;
+
+namespace
+{
+    // Largest component error of the linear part relative to the largest axis scale,
+    // and of the translation relative to its magnitude
+    f32 GetRoundTripError(const Mat4x3& transform)
+    {
+        auto unpacked = UnpackTRS(PackTRS(transform));
+
+        f32 scale = std::max({ glm::length(transform[0]), glm::length(transform[1]), glm::length(transform[2]), FLT_MIN });
+        f32 error = 0.f;
+        for (u32 c = 0; c < 3; ++c) {
+            Vec3 delta = glm::abs(unpacked[c] - transform[c]) / scale;
+            error = std::max({ error, delta.x, delta.y, delta.z });
+        }
+
+        Vec3 delta = glm::abs(unpacked[3] - transform[3]) / std::max(glm::length(transform[3]), 1.f);
+        return std::max({ error, delta.x, delta.y, delta.z });
+    }
+}
+
+AXIOM_TEST(CompiledScene_PackTRSRoundTrip)
+{
+    std::mt19937 rng(6);
+    std::uniform_real_distribution<f32> unit(-1.f, 1.f);
+    std::uniform_real_distribution<f32> log_scale(-2.f, 2.f);
+
+    f32 max_error = 0.f;
+    u32 mirrored_count = 0;
+    for (u32 i = 0; i < 10'000; ++i) {
+        Quat rotation = glm::normalize(Quat(unit(rng), unit(rng), unit(rng), unit(rng)));
+
+        // Non-uniform scales over four orders of magnitude, mirrored on a random axis
+        Vec3 scale(std::pow(10.f, log_scale(rng)), std::pow(10.f, log_scale(rng)), std::pow(10.f, log_scale(rng)));
+        bool mirrored = i % 2;
+        if (mirrored) {
+            scale[rng() % 3] *= -1.f;
+            mirrored_count++;
+        }
+
+        Mat4 transform = glm::translate(Mat4(1.f), Vec3(unit(rng), unit(rng), unit(rng)) * 1000.f)
+            * glm::mat4_cast(rotation)
+            * glm::scale(Mat4(1.f), scale);
+
+        f32 error = GetRoundTripError(Mat4x3(transform));
+        AXIOM_CHECK(error < 1e-4f);
+        max_error = std::max(max_error, error);
+
+        // Mirroring is preserved
+        auto unpacked = Mat3(Mat4(UnpackTRS(PackTRS(Mat4x3(transform)))));
+        AXIOM_CHECK((glm::determinant(unpacked) < 0.f) == mirrored);
+    }
+
+    NOVA_LOG("PackTRS: 10000 transforms ({} mirrored), max relative error = {}", mirrored_count, max_error);
+
+    // Shear is not representable
+
+    Mat4 shear(1.f);
+    shear[1][0] = 0.5f;
+    AXIOM_CHECK(GetRoundTripError(Mat4x3(shear)) > 1e-2f);
+}
@@ -0,0 +1,137 @@
+#include "axiom_Test.hpp"
+
+#include <scene/runtime/axiom_DynamicScene.hpp>
+
+using namespace axiom;
+
+namespace
+{
+    std::vector<SceneChange> ConsumeChanges(DynamicScene& scene)
+    {
+        std::vector<SceneChange> changes;
+        scene.ConsumeChanges(changes);
+        return changes;
+    }
+
+    bool IsChange(const SceneChange& change, ObjectType object, ChangeType type, u32 index)
+    {
+        return change.object == object && change.type == type && change.index == index;
+    }
+
+    Handle<TriMesh> AddTestMesh(DynamicScene& scene, Handle<UVMaterial> material)
+    {
+        TriMesh mesh;
+        mesh.sub_meshes.push_back({ .material = material.ToIndex() });
+        return scene.AddMesh(std::move(mesh));
+    }
+}
+
+AXIOM_TEST(DynamicScene_JournalCoalescing)
+{
+    DynamicScene scene;
+    auto texture = scene.AddTexture({});
+    auto material = scene.AddMaterial({ .normals = texture.ToIndex() });
+    auto mesh = AddTestMesh(scene, material);
+
+    // Updates to an object added in the same batch are folded into the add
+
+    auto instance = scene.AddInstance(mesh, Mat4x3(1.f));
+    scene.SetTransform(instance, Mat4x3(2.f));
+
+    auto changes = ConsumeChanges(scene);
+    AXIOM_CHECK(changes.size() == 4);
+    AXIOM_CHECK(IsChange(changes[0], ObjectType::Texture, ChangeType::Added, texture.index));
+    AXIOM_CHECK(IsChange(changes[1], ObjectType::Material, ChangeType::Added, material.index));
+    AXIOM_CHECK(IsChange(changes[2], ObjectType::Mesh, ChangeType::Added, mesh.index));
+    AXIOM_CHECK(IsChange(changes[3], ObjectType::Instance, ChangeType::Added, instance.index));
+
+    // Repeated updates produce a single change, objects added and removed in between produce none
+
+    scene.SetTransform(instance, Mat4x3(3.f));
+    scene.SetTransform(instance, Mat4x3(4.f));
+    auto temporary = scene.AddInstance(mesh, Mat4x3(1.f));
+    scene.SetTransform(temporary, Mat4x3(2.f));
+    scene.Remove(temporary);
+
+    changes = ConsumeChanges(scene);
+    AXIOM_CHECK(changes.size() == 1);
+    AXIOM_CHECK(IsChange(changes[0], ObjectType::Instance, ChangeType::Updated, instance.index));
+
+    // Removal replaces a pending update
+
+    scene.SetTransform(instance, Mat4x3(5.f));
+    scene.Remove(instance);
+
+    changes = ConsumeChanges(scene);
+    AXIOM_CHECK(changes.size() == 1);
+    AXIOM_CHECK(IsChange(changes[0], ObjectType::Instance, ChangeType::Removed, instance.index));
+
+    AXIOM_CHECK(ConsumeChanges(scene).empty());
+}
+
+AXIOM_TEST(DynamicScene_StaleHandles)
+{
+    DynamicScene scene;
+    auto material = scene.AddMaterial({});
+    auto mesh = AddTestMesh(scene, material);
+
+    auto instance = scene.AddInstance(mesh, Mat4x3(1.f));
+    scene.Remove(instance);
+    AXIOM_CHECK(!scene.IsAlive(instance));
+
+    // The slot is reused with a new generation
+
+    auto reused = scene.AddInstance(mesh, Mat4x3(1.f));
+    AXIOM_CHECK(reused.index == instance.index);
+    AXIOM_CHECK(reused.generation != instance.generation);
+    AXIOM_CHECK(scene.IsAlive(reused));
+    AXIOM_CHECK(!scene.IsAlive(instance));
+
+    AXIOM_CHECK_THROWS(scene.SetTransform(instance, Mat4x3(2.f)));
+    AXIOM_CHECK_THROWS(scene.Remove(instance));
+    AXIOM_CHECK(scene.IsAlive(reused));
+
+    scene.Remove(reused);
+    scene.Remove(mesh);
+    AXIOM_CHECK_THROWS(scene.AddInstance(mesh, Mat4x3(1.f)));
+}
+
+AXIOM_TEST(DynamicScene_RemoveReferenced)
+{
+    DynamicScene scene;
+    auto texture = scene.AddTexture({});
+    auto material = scene.AddMaterial({ .basecolor_alpha = texture.ToIndex(), .normals = texture.ToIndex() });
+    auto mesh = AddTestMesh(scene, material);
+    auto instance = scene.AddInstance(mesh, Mat4x3(1.f));
+
+    AXIOM_CHECK_THROWS(scene.Remove(texture));
+    AXIOM_CHECK_THROWS(scene.Remove(material));
+    AXIOM_CHECK_THROWS(scene.Remove(mesh));
+    AXIOM_CHECK(scene.IsAlive(texture) && scene.IsAlive(material) && scene.IsAlive(mesh));
+
+    // Objects become removable once their last referencing object is removed
+
+    scene.Remove(instance);
+    scene.Remove(mesh);
+    scene.Remove(material);
+    scene.Remove(texture);
+    AXIOM_CHECK(!scene.IsAlive(texture));
+}
+
+AXIOM_TEST(DynamicScene_FailedAddKeepsReferenceCounts)
+{
+    DynamicScene scene;
+    auto texture = scene.AddTexture({});
+    auto material = scene.AddMaterial({});
+
+    // The valid reference precedes the missing one, and must not remain acquired
+
+    AXIOM_CHECK_THROWS(scene.AddMaterial({ .basecolor_alpha = texture.ToIndex(), .normals = Index<UVTexture>(42) }));
+    scene.Remove(texture);
+
+    TriMesh mesh;
+    mesh.sub_meshes.push_back({ .material = material.ToIndex() });
+    mesh.sub_meshes.push_back({ .material = Index<UVMaterial>(42) });
+    AXIOM_CHECK_THROWS(scene.AddMesh(std::move(mesh)));
+    scene.Remove(material);
+}
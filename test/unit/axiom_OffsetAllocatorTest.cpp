@@ -0,0 +1,127 @@
+#include "axiom_Test.hpp"
+
+#include <renderers/axiom_OffsetAllocator.hpp>
+
+#include <chrono>
+#include <map>
+#include <random>
+
+using namespace axiom;
+
+AXIOM_TEST(OffsetAllocator_RandomStress)
+{
+    constexpr u32 Size = 1u << 26;
+
+    OffsetAllocator allocator(Size);
+    std::mt19937 rng(1);
+
+    struct LiveAllocation
+    {
+        OffsetAllocation allocation;
+        u32                    size;
+    };
+
+    std::vector<LiveAllocation> live;
+
+    // Ranges by offset, to check new allocations against their neighbours
+    std::map<u32, u32> live_ranges;
+    u64 used = 0;
+
+    for (u32 iteration = 0; iteration < 200'000; ++iteration) {
+        if (live.empty() || rng() % 100 < 55) {
+            u32 size = 1 + rng() % ((rng() % 10) ? 4096 : 262144);
+            u32 alignment = 1u << (rng() % 9);
+
+            auto allocation = allocator.Allocate(size, alignment);
+            if (!allocation.IsValid()) {
+                continue;
+            }
+
+            AXIOM_CHECK(allocation.offset % alignment == 0);
+            AXIOM_CHECK(u64(allocation.offset) + size <= Size);
+            AXIOM_CHECK(allocator.GetAllocationSize(allocation) >= size);
+
+            auto next = live_ranges.upper_bound(allocation.offset);
+            AXIOM_CHECK(next == live_ranges.end() || next->first >= allocation.offset + size);
+            if (next != live_ranges.begin()) {
+                auto prev = std::prev(next);
+                AXIOM_CHECK(prev->first + prev->second <= allocation.offset);
+            }
+
+            live_ranges[allocation.offset] = size;
+            used += allocator.GetAllocationSize(allocation);
+            live.push_back({ allocation, size });
+        } else {
+            u32 index = rng() % u32(live.size());
+            auto allocation = live[index].allocation;
+
+            used -= allocator.GetAllocationSize(allocation);
+            allocator.Free(allocation);
+            live_ranges.erase(allocation.offset);
+
+            live[index] = live.back();
+            live.pop_back();
+        }
+
+        if (iteration % 10'000 == 0) {
+            auto stats = allocator.GetStats();
+            AXIOM_CHECK(stats.total_free + used == Size);
+            AXIOM_CHECK(stats.allocations == live.size());
+            AXIOM_CHECK(stats.largest_free <= stats.total_free);
+        }
+    }
+
+    for (auto& allocation : live) {
+        allocator.Free(allocation.allocation);
+    }
+
+    // Freeing everything merges back into a single range
+
+    auto stats = allocator.GetStats();
+    AXIOM_CHECK(stats.total_free == Size);
+    AXIOM_CHECK(stats.largest_free == Size);
+    AXIOM_CHECK(stats.free_regions == 1);
+    AXIOM_CHECK(stats.allocations == 0);
+
+    if (!live.empty()) {
+        AXIOM_CHECK_THROWS(allocator.Free(live.front().allocation));
+    }
+}
+
+AXIOM_TEST(OffsetAllocator_Benchmark)
+{
+    OffsetAllocator allocator(1u << 30);
+    std::mt19937 rng(2);
+
+    std::vector<OffsetAllocation> allocations(1 << 16);
+    std::vector<u32> sizes(allocations.size());
+    for (auto& size : sizes) {
+        size = 16 + rng() % 8192;
+    }
+
+    // Fills, frees every other allocation, refills the holes with different sizes, then frees all
+
+    u64 operations = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (u32 round = 0; round < 20; ++round) {
+        for (u32 i = 0; i < allocations.size(); ++i) {
+            allocations[i] = allocator.Allocate(sizes[i], 16);
+        }
+        for (u32 i = 0; i < allocations.size(); i += 2) {
+            allocator.Free(allocations[i]);
+        }
+        for (u32 i = 0; i < allocations.size(); i += 2) {
+            allocations[i] = allocator.Allocate(sizes[i ^ 1], 16);
+        }
+        for (auto& allocation : allocations) {
+            AXIOM_CHECK(allocation.IsValid());
+            allocator.Free(allocation);
+        }
+        operations += allocations.size() * 3;
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    NOVA_LOG("OffsetAllocator: {:.1f} ns/op", std::chrono::duration<f64, std::nano>(end - start).count() / f64(operations));
+
+    AXIOM_CHECK(allocator.GetStats().free_regions == 1);
+}
@@ -0,0 +1,314 @@
+#include "axiom_Test.hpp"
+
+#include <scene/runtime/axiom_SceneCompiler.hpp>
+
+#include <chrono>
+#include <numeric>
+#include <random>
+
+using namespace axiom;
+
+AXIOM_TEST(SceneCompiler_PackIndices)
+{
+    SceneCompiler compiler;
+
+    TriMesh mesh;
+    mesh.position_attributes.resize(4);
+    mesh.indices = { 0, 1, 2, 0, 2, 3 };
+    mesh.sub_meshes.push_back({ .vertex_offset = 0, .max_vertex = 3, .first_index = 0, .index_count = 6 });
+
+    compiler.PackIndices(mesh);
+    AXIOM_CHECK(mesh.sub_meshes[0].index_type == nova::IndexType::U16);
+    AXIOM_CHECK(mesh.indices.empty());
+    AXIOM_CHECK((mesh.indices_u16 == std::vector<u16> { 0, 1, 2, 0, 2, 3 }));
+
+    // Indices beyond max_vertex would be truncated or read other sub meshes' vertices
+
+    TriMesh invalid;
+    invalid.position_attributes.resize(4);
+    invalid.indices = { 0, 1, 2, 0, 2, 7 };
+    invalid.sub_meshes.push_back({ .vertex_offset = 0, .max_vertex = 3, .first_index = 0, .index_count = 6 });
+    AXIOM_CHECK_THROWS(compiler.PackIndices(invalid));
+}
+
+namespace
+{
+    // Grid of quads in the XY plane, with vertices in row order
+    scene_ir::Mesh CreateGrid(u32 size, u32 material_idx)
+    {
+        scene_ir::Mesh mesh;
+        mesh.material_idx = material_idx;
+        for (u32 y = 0; y <= size; ++y) {
+            for (u32 x = 0; x <= size; ++x) {
+                mesh.positions.push_back(Vec3(f32(x), f32(y), 0.f));
+            }
+        }
+        for (u32 y = 0; y < size; ++y) {
+            for (u32 x = 0; x < size; ++x) {
+                u32 v = y * (size + 1) + x;
+                mesh.indices.insert(mesh.indices.end(), { v, v + 1, v + size + 2, v, v + size + 2, v + size + 1 });
+            }
+        }
+        return mesh;
+    }
+
+    void AddInstance(scene_ir::Scene& scene, u32 mesh_idx, Vec3 translation)
+    {
+        scene.instances.push_back({
+            .mesh_idx = mesh_idx,
+            .transform = Mat4x3(glm::translate(Mat4(1.f), translation)),
+        });
+    }
+
+    SceneCompiler CreateTestCompiler()
+    {
+        SceneCompiler compiler;
+        compiler.cache_meshes = false;
+        compiler.deduplicate_rigid_meshes = false;
+        compiler.flatten_unique_instances = false;
+        compiler.lod_levels = 0;
+        return compiler;
+    }
+}
+
+AXIOM_TEST(SceneCompiler_DeduplicateMeshes)
+{
+    scene_ir::Scene in_scene;
+    in_scene.materials.resize(2);
+    in_scene.meshes.push_back(CreateGrid(4, 0));
+    in_scene.meshes.push_back(CreateGrid(4, 0));
+    in_scene.meshes.push_back(CreateGrid(4, 1));
+    in_scene.meshes.push_back(CreateGrid(5, 0));
+    for (u32 i = 0; i < 4; ++i) {
+        AddInstance(in_scene, i, Vec3(f32(i) * 10.f, 0.f, 0.f));
+    }
+
+    // Identical geometry with a different material must not be shared
+
+    auto compiler = CreateTestCompiler();
+    compiler.deduplicate_materials = false;
+
+    CompiledScene scene;
+    compiler.Compile(in_scene, scene);
+
+    AXIOM_CHECK(scene.meshes.size() == 3);
+    AXIOM_CHECK(scene.instances.size() == 4);
+    AXIOM_CHECK(scene.instances[0].mesh == scene.instances[1].mesh);
+    AXIOM_CHECK(scene.instances[0].mesh != scene.instances[2].mesh);
+    AXIOM_CHECK(scene.instances[0].mesh != scene.instances[3].mesh);
+}
+
+AXIOM_TEST(SceneCompiler_SanitiseBeforeDeduplicate)
+{
+    scene_ir::Scene in_scene;
+    in_scene.materials.resize(1);
+    in_scene.meshes.push_back(CreateGrid(4, 0));
+    in_scene.meshes.push_back(CreateGrid(4, 0));
+    AddInstance(in_scene, 0, Vec3(0.f));
+    AddInstance(in_scene, 1, Vec3(10.f, 0.f, 0.f));
+
+    // Equal to the first mesh once the repeated and degenerate triangles are removed
+
+    auto& mesh = in_scene.meshes[1];
+    mesh.indices.insert(mesh.indices.end(), { mesh.indices[0], mesh.indices[1], mesh.indices[2] });
+    mesh.indices.insert(mesh.indices.end(), { 0, 0, 1 });
+    usz index_count = mesh.indices.size();
+
+    auto compiler = CreateTestCompiler();
+
+    CompiledScene scene;
+    compiler.Compile(in_scene, scene);
+
+    AXIOM_CHECK(scene.meshes.size() == 1);
+    AXIOM_CHECK(scene.instances[0].mesh == scene.instances[1].mesh);
+
+    // Without consuming, the input scene is left unmodified
+    AXIOM_CHECK(in_scene.meshes[1].indices.size() == index_count);
+}
+
+AXIOM_TEST(SceneCompiler_FlattenInconsistentMeshes)
+{
+    scene_ir::Scene in_scene;
+    in_scene.materials.resize(1);
+    for (u32 i = 0; i < 6; ++i) {
+        in_scene.meshes.push_back(CreateGrid(2, 0));
+        AddInstance(in_scene, i, Vec3(f32(i) * 10.f, 0.f, 0.f));
+    }
+
+    // Partial triangle, index past the end of the vertices, and non-finite position
+
+    in_scene.meshes[3].indices.push_back(0);
+    in_scene.meshes[4].indices[1] = u32(in_scene.meshes[4].positions.size());
+    in_scene.meshes[5].positions[2].x = std::numeric_limits<f32>::quiet_NaN();
+
+    auto compiler = CreateTestCompiler();
+
+    std::vector<SceneCompiler::RigidMatch> rigid_matches;
+    for (u32 i = 0; i < in_scene.meshes.size(); ++i) {
+        rigid_matches.push_back({ i, Mat4(1.f) });
+    }
+
+    std::vector<const scene_ir::Mesh*> meshes;
+    for (auto& mesh : in_scene.meshes) {
+        meshes.push_back(&mesh);
+    }
+
+    std::vector<scene_ir::Mesh> batch_meshes;
+    std::vector<scene_ir::Instance> batch_instances;
+    AXIOM_CHECK(compiler.FlattenInstances(meshes, in_scene.instances, {}, rigid_matches, batch_meshes, batch_instances));
+
+    // Only the consistent meshes are merged, the rest remain separately instanced
+
+    AXIOM_CHECK(batch_meshes.size() == 1);
+    AXIOM_CHECK(batch_instances.size() == 4);
+    AXIOM_CHECK(batch_meshes[0].indices.size() == 3 * in_scene.meshes[0].indices.size());
+    AXIOM_CHECK(std::ranges::all_of(batch_meshes[0].indices, [&](u32 index) {
+        return index < batch_meshes[0].positions.size();
+    }));
+    for (u32 i = 1; i < 4; ++i) {
+        AXIOM_CHECK(batch_instances[i].mesh_idx == 2 + i);
+    }
+}
+
+namespace
+{
+    // Single sub mesh grid with triangles and vertices in random order
+    TriMesh CreateShuffledGrid(u32 size, u32 seed)
+    {
+        std::mt19937 rng(seed);
+
+        u32 vertex_count = (size + 1) * (size + 1);
+        std::vector<u32> vertex_order(vertex_count);
+        std::iota(vertex_order.begin(), vertex_order.end(), 0);
+        std::ranges::shuffle(vertex_order, rng);
+
+        TriMesh mesh;
+        mesh.position_attributes.resize(vertex_count);
+        mesh.shading_attributes.resize(vertex_count);
+        for (u32 i = 0; i < vertex_count; ++i) {
+            u32 v = vertex_order[i];
+            mesh.position_attributes[i] = Vec3(f32(v % (size + 1)), f32(v / (size + 1)), 0.f);
+        }
+
+        std::vector<u32> location(vertex_count);
+        for (u32 i = 0; i < vertex_count; ++i) {
+            location[vertex_order[i]] = i;
+        }
+
+        std::vector<std::array<u32, 3>> triangles;
+        for (u32 y = 0; y < size; ++y) {
+            for (u32 x = 0; x < size; ++x) {
+                u32 v = y * (size + 1) + x;
+                triangles.push_back({ location[v], location[v + 1], location[v + size + 2] });
+                triangles.push_back({ location[v], location[v + size + 2], location[v + size + 1] });
+            }
+        }
+        std::ranges::shuffle(triangles, rng);
+        for (auto& triangle : triangles) {
+            mesh.indices.insert(mesh.indices.end(), triangle.begin(), triangle.end());
+        }
+
+        mesh.sub_meshes.push_back({
+            .vertex_offset = 0,
+            .max_vertex = vertex_count - 1,
+            .first_index = 0,
+            .index_count = u32(mesh.indices.size()),
+        });
+        ComputeBounds(mesh);
+
+        return mesh;
+    }
+
+    // Triangles as position triples, independent of vertex numbering and triangle order
+    std::vector<std::array<f32, 9>> GetSortedTriangles(const TriMesh& mesh)
+    {
+        std::vector<std::array<f32, 9>> triangles;
+        for (u32 i = 0; i < mesh.indices.size(); i += 3) {
+            auto& triangle = triangles.emplace_back();
+            for (u32 j = 0; j < 3; ++j) {
+                Vec3 position = mesh.position_attributes[mesh.indices[i + j]];
+                triangle[j * 3 + 0] = position.x;
+                triangle[j * 3 + 1] = position.y;
+                triangle[j * 3 + 2] = position.z;
+            }
+        }
+        std::ranges::sort(triangles);
+        return triangles;
+    }
+
+    f64 GetMeanCentroidStep(const TriMesh& mesh)
+    {
+        auto GetCentroid = [&](u32 i) {
+            return (mesh.position_attributes[mesh.indices[i + 0]]
+                + mesh.position_attributes[mesh.indices[i + 1]]
+                + mesh.position_attributes[mesh.indices[i + 2]]) / 3.f;
+        };
+
+        f64 distance = 0.0;
+        for (u32 i = 3; i < mesh.indices.size(); i += 3) {
+            distance += glm::distance(GetCentroid(i - 3), GetCentroid(i));
+        }
+        return distance / f64(mesh.indices.size() / 3 - 1);
+    }
+}
+
+AXIOM_TEST(SceneCompiler_ReorderTriangles)
+{
+    SceneCompiler compiler;
+
+    auto source = CreateShuffledGrid(32, 4);
+    auto mesh = source;
+    compiler.ReorderTriangles(mesh);
+
+    // Same triangles over the same vertices, with matching winding
+
+    AXIOM_CHECK(GetSortedTriangles(mesh) == GetSortedTriangles(source));
+
+    auto SortedPositions = [](const TriMesh& m) {
+        auto positions = m.position_attributes;
+        std::ranges::sort(positions, [](Vec3 l, Vec3 r) {
+            return std::tie(l.x, l.y, l.z) < std::tie(r.x, r.y, r.z);
+        });
+        return positions;
+    };
+    AXIOM_CHECK(SortedPositions(mesh) == SortedPositions(source));
+
+    // Vertices are numbered in order of first use
+
+    u32 next_vertex = 0;
+    for (u32 index : mesh.indices) {
+        AXIOM_CHECK(index <= next_vertex);
+        if (index == next_vertex) {
+            next_vertex++;
+        }
+    }
+    AXIOM_CHECK(next_vertex == mesh.GetVertexCount());
+
+    // Deterministic, and consecutive triangles are spatially coherent
+
+    auto again = source;
+    compiler.ReorderTriangles(again);
+    AXIOM_CHECK(again.indices == mesh.indices);
+    AXIOM_CHECK(again.position_attributes == mesh.position_attributes);
+
+    AXIOM_CHECK(GetMeanCentroidStep(mesh) < 0.25 * GetMeanCentroidStep(source));
+}
+
+AXIOM_TEST(SceneCompiler_ReorderTrianglesBenchmark)
+{
+    SceneCompiler compiler;
+
+    auto source = CreateShuffledGrid(512, 5);
+    auto mesh = source;
+
+    auto start = std::chrono::steady_clock::now();
+    compiler.ReorderTriangles(mesh);
+    auto end = std::chrono::steady_clock::now();
+
+    NOVA_LOG("ReorderTriangles: {} triangles, {:.1f} ns/triangle, mean centroid step {:.3f} -> {:.3f}",
+        mesh.indices.size() / 3,
+        std::chrono::duration<f64, std::nano>(end - start).count() / f64(mesh.indices.size() / 3),
+        GetMeanCentroidStep(source), GetMeanCentroidStep(mesh));
+
+    AXIOM_CHECK(GetMeanCentroidStep(mesh) < GetMeanCentroidStep(source));
+}
@@ -0,0 +1,85 @@
+#include "axiom_Test.hpp"
+
+#include <scene/runtime/axiom_SceneCompiler.hpp>
+#include <scene/runtime/axiom_SceneFile.hpp>
+
+using namespace axiom;
+
+AXIOM_TEST(SceneFile_TransformHierarchyRoundTrip)
+{
+    auto Translation = [](Vec3 offset) {
+        return Mat4x3(glm::translate(Mat4(1.f), offset));
+    };
+
+    scene_ir::Scene in_scene;
+    in_scene.materials.resize(1);
+
+    auto& mesh = in_scene.meshes.emplace_back();
+    mesh.material_idx = 0;
+    mesh.positions = { Vec3(0.f), Vec3(1.f, 0.f, 0.f), Vec3(0.f, 1.f, 0.f) };
+    mesh.indices = { 0, 1, 2 };
+
+    // Root, child and a second root, with one static instance
+
+    in_scene.nodes.push_back({ .parent = scene_ir::InvalidIndex, .transform = Translation(Vec3(1.f, 0.f, 0.f)) });
+    in_scene.nodes.push_back({ .parent = 0, .transform = Translation(Vec3(0.f, 2.f, 0.f)) });
+    in_scene.nodes.push_back({ .parent = scene_ir::InvalidIndex, .transform = Translation(Vec3(0.f, 0.f, 3.f)) });
+    in_scene.instances.push_back({ .mesh_idx = 0, .transform = Translation(Vec3(1.f, 2.f, 0.f)), .node_idx = 1 });
+    in_scene.instances.push_back({ .mesh_idx = 0, .transform = Translation(Vec3(0.f, 0.f, 3.f)), .node_idx = 2 });
+    in_scene.instances.push_back({ .mesh_idx = 0, .transform = Translation(Vec3(7.f, 0.f, 0.f)) });
+
+    SceneCompiler compiler;
+    compiler.cache_meshes = false;
+
+    CompiledScene scene;
+    compiler.Compile(in_scene, scene);
+    AXIOM_CHECK(scene.transforms.GetNodeCount() == 3);
+    AXIOM_CHECK(scene.instances.size() == 3);
+
+    auto path = std::filesystem::temp_directory_path() / "axiom-scene-file-test.axscene";
+    WriteSceneFile(scene, path);
+
+    {
+        MappedSceneFile file(path);
+
+        // Loaded nodes are appended after existing ones
+
+        CompiledScene loaded;
+        u32 offset = loaded.transforms.Add(TransformHierarchy::InvalidNode, Mat4x3(1.f)) + 1;
+        loaded.Load(*file.scene);
+
+        AXIOM_CHECK(loaded.transforms.GetNodeCount() == offset + 3);
+        for (u32 node = 0; node < 3; ++node) {
+            u32 parent = scene.transforms.GetParent(node);
+            AXIOM_CHECK(loaded.transforms.GetParent(offset + node) == (parent == TransformHierarchy::InvalidNode ? parent : offset + parent));
+            AXIOM_CHECK(loaded.transforms.GetLocal(offset + node) == scene.transforms.GetLocal(node));
+            AXIOM_CHECK(loaded.transforms.GetWorld(offset + node) == scene.transforms.GetWorld(node));
+        }
+
+        AXIOM_CHECK(loaded.instances.size() == 3);
+        for (u32 i = 0; i < 3; ++i) {
+            auto& instance = scene.instances[i];
+            auto& loaded_instance = loaded.instances[i];
+            AXIOM_CHECK(loaded_instance.node == (instance.node == TransformHierarchy::InvalidNode ? instance.node : offset + instance.node));
+            AXIOM_CHECK(loaded_instance.transform == instance.transform);
+        }
+
+        // Moving a loaded root moves its descendants' instances, and nothing else
+
+        loaded.transforms.SetLocal(offset, Translation(Vec3(5.f, 0.f, 0.f)));
+        loaded.UpdateTransforms();
+
+        for (auto& instance : loaded.instances) {
+            if (instance.node == offset + 1) {
+                AXIOM_CHECK(instance.transform[3] == Vec3(5.f, 2.f, 0.f));
+                AXIOM_CHECK(instance.world_min.x >= 5.f);
+            } else if (instance.node == offset + 2) {
+                AXIOM_CHECK(instance.transform[3] == Vec3(0.f, 0.f, 3.f));
+            } else {
+                AXIOM_CHECK(instance.transform[3] == Vec3(7.f, 0.f, 0.f));
+            }
+        }
+    }
+
+    std::filesystem::remove(path);
+}
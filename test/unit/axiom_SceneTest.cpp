@@ -0,0 +1,41 @@
+#include "axiom_Test.hpp"
+
+#include <scene/axiom_Scene.hpp>
+
+using namespace axiom;
+
+AXIOM_TEST(Scene_MaterialProperties)
+{
+    scene_ir::Material material;
+
+    // Well known keys hold one value per type
+
+    material.SetProperty(scene_ir::property::BaseColor, scene_ir::TextureSwizzle{ .texture_idx = 3 });
+    material.SetProperty(scene_ir::property::BaseColor, Vec4(1.f, 0.5f, 0.25f, 1.f));
+    material.SetProperty(scene_ir::property::Metallic, 0.25f);
+    material.SetProperty(scene_ir::property::Metallic, 0.75f);
+
+    AXIOM_CHECK(material.properties.size() == 3);
+    AXIOM_CHECK(material.GetProperty<scene_ir::TextureSwizzle>(scene_ir::property::BaseColor)->texture_idx == 3);
+    AXIOM_CHECK(*material.GetProperty<Vec4>(scene_ir::property::BaseColor) == Vec4(1.f, 0.5f, 0.25f, 1.f));
+    AXIOM_CHECK(*material.GetProperty<f32>(scene_ir::property::Metallic) == 0.75f);
+    AXIOM_CHECK(!material.GetProperty<f32>(scene_ir::property::BaseColor));
+    AXIOM_CHECK(!material.GetProperty<f32>(scene_ir::property::Roughness));
+
+    // Other names are interned, and found by scanning
+
+    auto custom = scene_ir::InternProperty("test_custom_property");
+    AXIOM_CHECK(custom.id >= scene_ir::property::WellKnownCount);
+    AXIOM_CHECK(scene_ir::InternProperty("roughness") == scene_ir::property::Roughness);
+
+    material.SetProperty(custom, 2);
+    material.SetProperty(custom, 5);
+    AXIOM_CHECK(material.properties.size() == 4);
+    AXIOM_CHECK(*material.GetProperty<i32>(custom) == 5);
+    AXIOM_CHECK(!material.GetProperty<bool>(custom));
+
+    // Copies keep their slots
+
+    const auto copy = material;
+    AXIOM_CHECK(*copy.GetProperty<f32>(scene_ir::property::Metallic) == 0.75f);
+}
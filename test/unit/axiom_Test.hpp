@@ -0,0 +1,49 @@
+#pragma once
+
+#include <axiom_Core.hpp>
+
+namespace axiom::test
+{
+    struct TestCase
+    {
+        const char*     name;
+        void        (*function)();
+    };
+
+    inline
+    std::vector<TestCase>& GetTests()
+    {
+        static std::vector<TestCase> tests;
+        return tests;
+    }
+
+    struct TestRegistrar
+    {
+        TestRegistrar(const char* name, void(*function)())
+        {
+            GetTests().push_back({ name, function });
+        }
+    };
+}
+
+// Defines a test case, registered with the test runner at static initialization
+#define AXIOM_TEST(name)                                                  \
+    static void AxiomTest_##name();                                       \
+    static ::axiom::test::TestRegistrar AxiomTestRegistrar_##name{ #name, AxiomTest_##name }; \
+    static void AxiomTest_##name()
+
+// Fails the current test by throwing if the condition does not hold
+#define AXIOM_CHECK(condition) do {                                       \
+    if (!(condition)) {                                                   \
+        NOVA_THROW("Check failed: {} ({}:{})", #condition, __FILE__, __LINE__); \
+    }                                                                     \
+} while (0)
+
+// Fails the current test unless the expression throws
+#define AXIOM_CHECK_THROWS(expression) do {                               \
+    bool threw = false;                                                   \
+    try { expression; } catch (...) { threw = true; }                     \
+    if (!threw) {                                                         \
+        NOVA_THROW("Expected throw: {} ({}:{})", #expression, __FILE__, __LINE__); \
+    }                                                                     \
+} while (0)
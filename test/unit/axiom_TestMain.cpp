@@ -0,0 +1,39 @@
+#include "axiom_Test.hpp"
+
+// Runs every registered test, or only those whose names contain one of the arguments
+
+int main(int argc, char* argv[])
+{
+    using namespace axiom;
+
+    u32 run = 0;
+    u32 failed = 0;
+
+    for (auto& test : test::GetTests()) {
+        if (argc > 1) {
+            bool selected = false;
+            for (i32 i = 1; i < argc; ++i) {
+                selected |= std::string_view(test.name).contains(argv[i]);
+            }
+            if (!selected) {
+                continue;
+            }
+        }
+
+        run++;
+        try {
+            test.function();
+            NOVA_LOG("[PASS] {}", test.name);
+        } catch (std::exception& e) {
+            NOVA_LOG("[FAIL] {}: {}", test.name, e.what());
+            failed++;
+        } catch (...) {
+            NOVA_LOG("[FAIL] {}: Unknown exception", test.name);
+            failed++;
+        }
+    }
+
+    NOVA_LOG("{} / {} tests passed", run - failed, run);
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,90 @@
+#include "axiom_Test.hpp"
+
+#include <scene/runtime/axiom_TransformHierarchy.hpp>
+
+using namespace axiom;
+
+namespace
+{
+    Mat4x3 Translation(Vec3 offset)
+    {
+        return Mat4x3(glm::translate(Mat4(1.f), offset));
+    }
+
+    Vec3 GetTranslation(const TransformHierarchy& hierarchy, u32 node)
+    {
+        return hierarchy.GetWorld(node)[3];
+    }
+}
+
+AXIOM_TEST(TransformHierarchy_Propagation)
+{
+    TransformHierarchy hierarchy;
+    u32 root = hierarchy.Add(TransformHierarchy::InvalidNode, Translation(Vec3(1.f, 0.f, 0.f)));
+    u32 child = hierarchy.Add(root, Translation(Vec3(0.f, 2.f, 0.f)));
+    u32 grandchild = hierarchy.Add(child, Mat4x3(glm::scale(Mat4(1.f), Vec3(2.f))));
+    u32 sibling = hierarchy.Add(root, Translation(Vec3(0.f, 0.f, 3.f)));
+    u32 other_root = hierarchy.Add(TransformHierarchy::InvalidNode, Translation(Vec3(5.f)));
+
+    AXIOM_CHECK_THROWS(hierarchy.Add(7, Mat4x3(1.f)));
+
+    hierarchy.Update();
+    AXIOM_CHECK(GetTranslation(hierarchy, child) == Vec3(1.f, 2.f, 0.f));
+    AXIOM_CHECK(GetTranslation(hierarchy, grandchild) == Vec3(1.f, 2.f, 0.f));
+    AXIOM_CHECK(GetTranslation(hierarchy, sibling) == Vec3(1.f, 0.f, 3.f));
+    AXIOM_CHECK(hierarchy.GetWorld(grandchild)[0] == Vec3(2.f, 0.f, 0.f));
+
+    // Changing a node updates exactly its subtree, using the parent's new world transform
+
+    hierarchy.SetLocal(child, Translation(Vec3(0.f, 4.f, 0.f)));
+    hierarchy.Update();
+    AXIOM_CHECK(GetTranslation(hierarchy, child) == Vec3(1.f, 4.f, 0.f));
+    AXIOM_CHECK(GetTranslation(hierarchy, grandchild) == Vec3(1.f, 4.f, 0.f));
+    AXIOM_CHECK(hierarchy.IsUpdated(child) && hierarchy.IsUpdated(grandchild));
+    AXIOM_CHECK(!hierarchy.IsUpdated(root) && !hierarchy.IsUpdated(sibling) && !hierarchy.IsUpdated(other_root));
+
+    // Parent and child changed together resolve in order
+
+    hierarchy.SetLocal(grandchild, Translation(Vec3(0.f, 0.f, 1.f)));
+    hierarchy.SetLocal(root, Translation(Vec3(-1.f, 0.f, 0.f)));
+    hierarchy.Update();
+    AXIOM_CHECK(GetTranslation(hierarchy, grandchild) == Vec3(-1.f, 4.f, 1.f));
+    AXIOM_CHECK(GetTranslation(hierarchy, sibling) == Vec3(-1.f, 0.f, 3.f));
+    AXIOM_CHECK(!hierarchy.IsUpdated(other_root));
+
+    hierarchy.Update();
+    AXIOM_CHECK(!hierarchy.IsUpdated(root) && !hierarchy.IsUpdated(grandchild));
+}
+
+AXIOM_TEST(TransformHierarchy_AppendAfterUpdate)
+{
+    // Nodes appended after an update are out of depth order until the next update sorts them
+
+    TransformHierarchy hierarchy;
+    u32 root = hierarchy.Add(TransformHierarchy::InvalidNode, Translation(Vec3(1.f, 0.f, 0.f)));
+    u32 child = hierarchy.Add(root, Translation(Vec3(0.f, 1.f, 0.f)));
+    hierarchy.Update();
+
+    u32 grandchild = hierarchy.Add(child, Translation(Vec3(0.f, 0.f, 1.f)));
+    u32 new_root = hierarchy.Add(TransformHierarchy::InvalidNode, Translation(Vec3(2.f, 0.f, 0.f)));
+    u32 new_child = hierarchy.Add(new_root, Translation(Vec3(0.f, 2.f, 0.f)));
+    u32 root_child = hierarchy.Add(root, Translation(Vec3(0.f, 0.f, 2.f)));
+    hierarchy.SetLocal(root, Translation(Vec3(3.f, 0.f, 0.f)));
+    hierarchy.Update();
+
+    AXIOM_CHECK(hierarchy.GetNodeCount() == 6);
+    AXIOM_CHECK(GetTranslation(hierarchy, grandchild) == Vec3(3.f, 1.f, 1.f));
+    AXIOM_CHECK(GetTranslation(hierarchy, new_child) == Vec3(2.f, 2.f, 0.f));
+    AXIOM_CHECK(GetTranslation(hierarchy, root_child) == Vec3(3.f, 0.f, 2.f));
+
+    // Node ids are unaffected by sorting
+
+    AXIOM_CHECK(hierarchy.GetParent(grandchild) == child);
+    AXIOM_CHECK(hierarchy.GetParent(root_child) == root);
+    AXIOM_CHECK(hierarchy.GetLocal(new_root) == Translation(Vec3(2.f, 0.f, 0.f)));
+
+    hierarchy.SetLocal(new_root, Translation(Vec3(0.f)));
+    hierarchy.Update();
+    AXIOM_CHECK(GetTranslation(hierarchy, new_child) == Vec3(0.f, 2.f, 0.f));
+    AXIOM_CHECK(!hierarchy.IsUpdated(grandchild));
+}
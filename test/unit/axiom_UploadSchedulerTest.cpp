@@ -0,0 +1,192 @@
+#include "axiom_Test.hpp"
+
+#include <renderers/axiom_UploadScheduler.hpp>
+
+#include <random>
+
+using namespace axiom;
+
+namespace
+{
+    struct SimulationStats
+    {
+        u64 frames = 0;
+        u64 max_frame_bytes = 0;
+        u64 max_ring_used = 0;
+        bool wrapped = false;
+    };
+
+    // Simulates a GPU that executes each frame's copies out of the staging memory a fixed
+    // number of frames after submission, checking that staging ranges are never rewritten
+    // while in flight and that every upload arrives intact
+    SimulationStats Simulate(u64 ring_size, u64 frame_budget, u64 chunk_size)
+    {
+        constexpr u64 Latency = 2;
+        constexpr u64 TargetSize = 16ull << 20;
+
+        UploadScheduler scheduler(ring_size);
+        scheduler.frame_budget = frame_budget;
+        scheduler.chunk_size = chunk_size;
+
+        std::vector<b8> staging(ring_size);
+        std::vector<std::vector<b8>> targets(3, std::vector<b8>(TargetSize));
+
+        struct Upload
+        {
+            std::vector<b8> data;
+            u32           target;
+            u64           offset;
+            u64           ticket;
+        };
+
+        // Mix of small uploads, uploads larger than the ring and budget, and an empty upload
+
+        std::mt19937 rng(3);
+        std::vector<Upload> uploads;
+        std::array<u64, 3> target_offsets = {};
+        for (u32 i = 0; i < 80; ++i) {
+            u64 size = (i % 7 == 0) ? 3'000'000 : rng() % 50'000;
+            if (i == 5) {
+                size = 0;
+            }
+
+            u32 target = rng() % 3;
+            if (target_offsets[target] + size > TargetSize) {
+                continue;
+            }
+
+            auto& upload = uploads.emplace_back();
+            upload.data.resize(size);
+            for (auto& byte : upload.data) {
+                byte = b8(rng());
+            }
+            upload.target = target;
+            upload.offset = target_offsets[target];
+            target_offsets[target] += size;
+        }
+
+        // Enqueued once the vector has stopped growing, as source data must stay valid
+
+        for (auto& upload : uploads) {
+            upload.ticket = scheduler.Enqueue(upload.target, upload.offset, upload.data.data(), upload.data.size());
+        }
+
+        struct Frame
+        {
+            u64                       id;
+            std::vector<UploadCopy> copies;
+        };
+
+        SimulationStats stats;
+        std::vector<Frame> in_flight;
+        u64 completed = 0;
+        u64 last_end = 0;
+
+        for (u64 frame = 1;; ++frame) {
+            while (!in_flight.empty() && in_flight.front().id + Latency <= frame) {
+                for (auto& copy : in_flight.front().copies) {
+                    std::memcpy(targets[copy.target].data() + copy.target_offset, staging.data() + copy.staging_offset, copy.size);
+                }
+                completed = in_flight.front().id;
+                in_flight.erase(in_flight.begin());
+            }
+
+            if (!scheduler.GetPendingBytes() && scheduler.IsComplete(uploads.back().ticket)) {
+                stats.frames = frame;
+                break;
+            }
+
+            AXIOM_CHECK(frame < 10'000);
+
+            // Staging ranges still in flight must not be handed out again, so their contents
+            // are captured before scheduling and compared afterwards
+
+            std::vector<std::vector<b8>> in_flight_contents;
+            for (auto& pending_frame : in_flight) {
+                for (auto& copy : pending_frame.copies) {
+                    auto* bytes = staging.data() + copy.staging_offset;
+                    in_flight_contents.emplace_back(bytes, bytes + copy.size);
+                }
+            }
+
+            std::vector<UploadCopy> copies;
+            scheduler.Schedule(frame, completed, staging.data(), copies);
+
+            usz content_idx = 0;
+            for (auto& pending_frame : in_flight) {
+                for (auto& copy : pending_frame.copies) {
+                    auto& contents = in_flight_contents[content_idx++];
+                    AXIOM_CHECK(std::memcmp(staging.data() + copy.staging_offset, contents.data(), contents.size()) == 0);
+                }
+            }
+
+            u64 frame_bytes = 0;
+            for (auto& copy : copies) {
+                AXIOM_CHECK(copy.staging_offset + copy.size <= ring_size);
+                AXIOM_CHECK(copy.staging_offset % scheduler.alignment == 0);
+                stats.wrapped |= copy.staging_offset < last_end;
+                last_end = copy.staging_offset + copy.size;
+                frame_bytes += copy.size;
+            }
+
+            AXIOM_CHECK(frame_bytes <= frame_budget);
+            AXIOM_CHECK(scheduler.GetRing().GetUsed() <= ring_size);
+
+            stats.max_frame_bytes = std::max(stats.max_frame_bytes, frame_bytes);
+            stats.max_ring_used = std::max(stats.max_ring_used, scheduler.GetRing().GetUsed());
+
+            in_flight.push_back({ frame, std::move(copies) });
+        }
+
+        for (auto& upload : uploads) {
+            AXIOM_CHECK(scheduler.IsComplete(upload.ticket));
+            AXIOM_CHECK(std::memcmp(targets[upload.target].data() + upload.offset, upload.data.data(), upload.data.size()) == 0);
+        }
+
+        return stats;
+    }
+}
+
+AXIOM_TEST(UploadScheduler_RingLargerThanBudget)
+{
+    auto stats = Simulate(1 << 20, 300'000, 100'000);
+
+    AXIOM_CHECK(stats.wrapped);
+    AXIOM_CHECK(stats.max_frame_bytes == 300'000);
+
+    NOVA_LOG("UploadScheduler: {} frames, max ring used = {}", stats.frames, stats.max_ring_used);
+}
+
+AXIOM_TEST(UploadScheduler_RingSmallerThanBudget)
+{
+    // The ring limits each frame instead of the budget
+
+    auto stats = Simulate(250'000, 300'000, 100'000);
+
+    AXIOM_CHECK(stats.wrapped);
+    AXIOM_CHECK(stats.max_frame_bytes <= 250'000);
+
+    NOVA_LOG("UploadScheduler: {} frames, max ring used = {}", stats.frames, stats.max_ring_used);
+}
+
+AXIOM_TEST(UploadScheduler_CopiesNotMergedAcrossFrames)
+{
+    // Consecutive frames stage contiguous chunks of one upload, which must remain
+    // separate copies when the caller appends every frame to the same vector
+
+    UploadScheduler scheduler(1 << 20);
+    scheduler.frame_budget = 1024;
+    scheduler.chunk_size = 1024;
+
+    std::vector<b8> staging(1 << 20);
+    std::vector<b8> data(2048);
+    scheduler.Enqueue(0, 0, data.data(), data.size());
+
+    std::vector<UploadCopy> copies;
+    scheduler.Schedule(1, 0, staging.data(), copies);
+    AXIOM_CHECK(copies.size() == 1);
+    scheduler.Schedule(2, 0, staging.data(), copies);
+    AXIOM_CHECK(copies.size() == 2);
+    AXIOM_CHECK(copies[0].size == 1024 && copies[1].size == 1024);
+    AXIOM_CHECK(copies[1].staging_offset == copies[0].staging_offset + 1024);
+}